@@ -1,65 +1,484 @@
 /* NAME: Anirudh Veeraragavan
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <time.h>
 #include <errno.h>
 #include <string.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
 
 // Global Constants
 const int SUCCESS_CODE = 0;
 const int ERR_CODE = 1;
 const int FAIL_CODE = 2;
 
+// Latency histogram: log-linear buckets, 2^HIST_SUB_BITS per power of two
+#define HIST_SUB_BITS 5
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB_COUNT)
+
+// Highest NUMA node number we look for in sysfs
+#define MAX_NODES 64
+
+// Most values a --sweep list may hold
+#define MAX_SWEEP 64
+
+// Hardware counters sampled with --perf, in CSV column order
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_LLC_MISSES 2
+#define PERF_TRANSFERS 3
+#define NUM_PERF 4
+
 struct thread_args {
 	long long* counter;
 	int iterations;
 };
 
+struct latency_hist {
+	long long count;
+	long long buckets[HIST_BUCKETS];
+};
+
+// Counter values summed over threads, -1 when not available
+struct perf_counts {
+	long long value[NUM_PERF];
+};
+
+struct cpu_place {
+	int cpu;
+	int package;
+	int core;
+	int sibling;
+};
+
+// Measurements from one run of the test
+struct run_result {
+	int iterations;
+	long long operations;
+	long long run_time;
+	long long counter;
+	struct perf_counts perf;
+};
+
+// Ticket lock: waiters are served in the order they took a ticket
+struct ticket_lock {
+	unsigned int next_ticket;
+	unsigned int now_serving;
+};
+
+// MCS lock: each waiter spins on a flag in its own queue node
+struct mcs_node {
+	struct mcs_node* next;
+	int locked;
+} __attribute__((aligned(64)));
+
+struct mcs_lock {
+	struct mcs_node* tail;
+};
+
+// CLH lock: each waiter spins on the node of its predecessor
+struct clh_node {
+	int locked;
+} __attribute__((aligned(64)));
+
+struct clh_lock {
+	struct clh_node* tail;
+};
+
+// Flat combining: a thread publishes its pending add in its own slot
+// and whoever holds the combiner lock applies every published request
+struct fc_slot {
+	long long value;
+	int pending;
+} __attribute__((aligned(64)));
+
 // Global Variables
 pthread_mutex_t mutexsum;
 char* sync_method;
 int opt_yield;
 int spin_lock = 0;
+struct ticket_lock ticket_sum = {0, 0};
+struct mcs_lock mcs_sum = {NULL};
+struct clh_lock clh_sum = {NULL};
+struct clh_node* clh_nodes = NULL;
+struct fc_slot* fc_slots = NULL;
+int fc_lock = 0;
+int num_slots = 0;
+int next_thread_index = 0;
+int opt_latency = 0;
+struct latency_hist* hists = NULL;
+char* affinity = NULL;
+char* numa_policy = NULL;
+int* thread_cpu = NULL;
+pthread_barrier_t start_barrier;
+double duration = 0;
+int stop_flag = 0;
+long long* thread_pairs = NULL;
+int opt_sweep = 0;
+int sweep_reps = 5;
+int sweep_warmup = 1;
+int backoff_cap = 1024;
+int spin_limit = 100;
+int batch_size = 1;
+int opt_perf = 0;
+unsigned long long perf_raw_transfers = 0;
+struct perf_counts* thread_perf = NULL;
+
+// Per thread queue state for the MCS and CLH locks
+__thread int my_index;
+__thread struct mcs_node mcs_me;
+__thread struct clh_node* clh_me;
+__thread struct clh_node* clh_pred;
+
+// Hint to the CPU that we are in a spin-wait loop
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// INPUT: Spins so far in the current wait
+// Relax for spin_limit spins, then yield so that a preempted lock holder
+// or queue successor can run when there are more threads than CPUs
+static inline void spin_pause(int* spins)
+{
+	if (++*spins < spin_limit)
+	{
+		cpu_relax();
+		return;
+	}
+	*spins = 0;
+	sched_yield();
+}
 
-void add(long long *pointer, long long value)
+// Test-and-test-and-set: spin on a plain read and only attempt the
+// atomic once the lock looks free, backing off exponentially on failure
+void ttas_acquire(int* l)
 {
-	if (sync_method && *sync_method == 'm')
-		pthread_mutex_lock(&mutexsum);
+	int delay = 1;
+	while (1)
+	{
+		while (__atomic_load_n(l, __ATOMIC_RELAXED))
+			cpu_relax();
+
+		if (!__sync_lock_test_and_set(l, 1))
+			return;
 
-	if (sync_method && *sync_method == 's')
-		while(__sync_lock_test_and_set(&spin_lock, 1));
+		int i;
+		for (i = 0; i < delay; i++)
+			cpu_relax();
+		if (delay < backoff_cap)
+			delay <<= 1;
+	}
+}
 
-	long long prev;
-	long long sum;
-	if (sync_method && *sync_method == 'c')
+// Spin-then-park lock: 0 = free, 1 = held, 2 = held with sleepers
+// Spins for up to spin_limit tries before sleeping in the kernel
+void futex_acquire(int* l)
+{
+	int c = 0;
+	if (__atomic_compare_exchange_n(l, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	int i;
+	for (i = 0; i < spin_limit; i++)
+	{
+		c = 0;
+		if (__atomic_load_n(l, __ATOMIC_RELAXED) == 0 &&
+			__atomic_compare_exchange_n(l, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+		cpu_relax();
+	}
+
+	// Mark the lock contended so the holder knows to wake us
+	c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+	while (c != 0)
+	{
+		syscall(SYS_futex, l, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+		c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+void futex_release(int* l)
+{
+	if (__atomic_exchange_n(l, 0, __ATOMIC_RELEASE) == 2)
+		syscall(SYS_futex, l, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void ticket_acquire(struct ticket_lock* l)
+{
+	unsigned int my_ticket = __atomic_fetch_add(&l->next_ticket, 1, __ATOMIC_RELAXED);
+	int spins = 0;
+	while (__atomic_load_n(&l->now_serving, __ATOMIC_ACQUIRE) != my_ticket)
+		spin_pause(&spins);
+}
+
+void ticket_release(struct ticket_lock* l)
+{
+	// Only the holder writes now_serving, so a plain increment is safe
+	__atomic_store_n(&l->now_serving, l->now_serving + 1, __ATOMIC_RELEASE);
+}
+
+void mcs_acquire(struct mcs_lock* l, struct mcs_node* me)
+{
+	me->next = NULL;
+	me->locked = 1;
+
+	struct mcs_node* pred = __atomic_exchange_n(&l->tail, me, __ATOMIC_ACQ_REL);
+	if (pred == NULL)
+		return;
+
+	__atomic_store_n(&pred->next, me, __ATOMIC_RELEASE);
+	int spins = 0;
+	while (__atomic_load_n(&me->locked, __ATOMIC_ACQUIRE))
+		spin_pause(&spins);
+}
+
+void mcs_release(struct mcs_lock* l, struct mcs_node* me)
+{
+	struct mcs_node* succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE);
+	if (succ == NULL)
+	{
+		// No known successor, try to swing the tail back to empty
+		struct mcs_node* expected = me;
+		if (__atomic_compare_exchange_n(&l->tail, &expected, NULL, 0,
+										__ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return;
+
+		// A successor is enqueueing itself, wait for it to link in
+		int spins = 0;
+		while ((succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE)) == NULL)
+			spin_pause(&spins);
+	}
+	__atomic_store_n(&succ->locked, 0, __ATOMIC_RELEASE);
+}
+
+// Returns the predecessor's node, which the caller reuses next time
+struct clh_node* clh_acquire(struct clh_lock* l, struct clh_node* me)
+{
+	__atomic_store_n(&me->locked, 1, __ATOMIC_RELAXED);
+	struct clh_node* pred = __atomic_exchange_n(&l->tail, me, __ATOMIC_ACQ_REL);
+	int spins = 0;
+	while (__atomic_load_n(&pred->locked, __ATOMIC_ACQUIRE))
+		spin_pause(&spins);
+	return pred;
+}
+
+void clh_release(struct clh_node* me)
+{
+	__atomic_store_n(&me->locked, 0, __ATOMIC_RELEASE);
+}
+
+// INPUT: Counter to update, value to add
+// Publish the add, then either become the combiner or wait to be served
+void fc_add(long long *pointer, long long value)
+{
+	struct fc_slot* mine = &fc_slots[my_index];
+	mine->value = value;
+	__atomic_store_n(&mine->pending, 1, __ATOMIC_RELEASE);
+
+	while (__atomic_load_n(&mine->pending, __ATOMIC_ACQUIRE))
 	{
-		do
+		if (__atomic_load_n(&fc_lock, __ATOMIC_RELAXED) == 0 &&
+			!__sync_lock_test_and_set(&fc_lock, 1))
 		{
-			prev = *pointer;
-			sum = prev + value;
+			// Combiner: apply the whole batch with one lock handoff
+			long long sum = *pointer;
+			int i;
+			for (i = 0; i < num_slots; i++)
+			{
+				if (__atomic_load_n(&fc_slots[i].pending, __ATOMIC_ACQUIRE))
+				{
+					sum += fc_slots[i].value;
+					__atomic_store_n(&fc_slots[i].pending, 0, __ATOMIC_RELEASE);
+				}
+			}
+
 			if (opt_yield)
 				sched_yield();
-		} while(__sync_val_compare_and_swap(pointer, prev, sum) != prev);
-		return;
+
+			*pointer = sum;
+			__sync_lock_release(&fc_lock);
+			return;
+		}
+		cpu_relax();
+	}
+}
+
+void spin_acquire(int* l)
+{
+	while(__sync_lock_test_and_set(l, 1));
+}
+
+void clh_acquire_sum()
+{
+	clh_pred = clh_acquire(&clh_sum, clh_me);
+}
+
+void clh_release_sum()
+{
+	clh_release(clh_me);
+	clh_me = clh_pred;
+}
+
+// Critical sections for each sync method. They are macros so every
+// generated variant below gets its own copy with the lock calls and
+// yield decided at compile time instead of looked up on every add
+#define PLAIN_ADD(pointer, value, yield)		\
+	do {										\
+		long long sum = *(pointer) + (value);	\
+		if (yield)								\
+			sched_yield();						\
+		*(pointer) = sum;						\
+	} while (0)
+
+#define LOCKED_ADD(acquire, release, pointer, value, yield)	\
+	do {													\
+		acquire;											\
+		PLAIN_ADD(pointer, value, yield);					\
+		release;											\
+	} while (0)
+
+#define CAS_ADD(pointer, value, yield)										\
+	do {																	\
+		long long prev;														\
+		do {																\
+			prev = *(pointer);												\
+			if (yield)														\
+				sched_yield();												\
+		} while (__sync_val_compare_and_swap(pointer, prev, prev + (value)) != prev);	\
+	} while (0)
+
+// Single fetch-and-add instruction, no retry loop
+#define FETCH_ADD(order, pointer, value, yield)		\
+	do {											\
+		if (yield)									\
+			sched_yield();							\
+		__atomic_fetch_add(pointer, value, order);	\
+	} while (0)
+
+#define ADD_NONE(p, v, y) PLAIN_ADD(p, v, y)
+#define ADD_MUTEX(p, v, y) LOCKED_ADD(pthread_mutex_lock(&mutexsum), pthread_mutex_unlock(&mutexsum), p, v, y)
+#define ADD_SPIN(p, v, y) LOCKED_ADD(spin_acquire(&spin_lock), __sync_lock_release(&spin_lock), p, v, y)
+#define ADD_TTAS(p, v, y) LOCKED_ADD(ttas_acquire(&spin_lock), __sync_lock_release(&spin_lock), p, v, y)
+#define ADD_FUTEX(p, v, y) LOCKED_ADD(futex_acquire(&spin_lock), futex_release(&spin_lock), p, v, y)
+#define ADD_TICKET(p, v, y) LOCKED_ADD(ticket_acquire(&ticket_sum), ticket_release(&ticket_sum), p, v, y)
+#define ADD_MCS(p, v, y) LOCKED_ADD(mcs_acquire(&mcs_sum, &mcs_me), mcs_release(&mcs_sum, &mcs_me), p, v, y)
+#define ADD_CLH(p, v, y) LOCKED_ADD(clh_acquire_sum(), clh_release_sum(), p, v, y)
+#define ADD_CAS(p, v, y) CAS_ADD(p, v, y)
+#define ADD_SEQ_CST(p, v, y) FETCH_ADD(__ATOMIC_SEQ_CST, p, v, y)
+#define ADD_ACQ_REL(p, v, y) FETCH_ADD(__ATOMIC_ACQ_REL, p, v, y)
+#define ADD_RELAXED(p, v, y) FETCH_ADD(__ATOMIC_RELAXED, p, v, y)
+#define ADD_COMBINE(p, v, y) fc_add(p, v)
+
+// Generate add_<name>, a single add, and run_<name>, the whole worker
+// loop with the add expanded inline. run_<name> returns the number of
+// add/subtract pairs done
+#define DEFINE_ADD_VARIANT(name, body, yield)							\
+	void add_##name(long long *pointer, long long value)				\
+	{																	\
+		body(pointer, value, yield);									\
+	}																	\
+																		\
+	long long run_##name(long long *pointer, int iterations)			\
+	{																	\
+		long long pairs = 0;											\
+		int i;															\
+		if (duration > 0)												\
+		{																\
+			while (!__atomic_load_n(&stop_flag, __ATOMIC_RELAXED))		\
+			{															\
+				body(pointer, 1, yield);								\
+				body(pointer, -1, yield);								\
+				pairs++;												\
+			}															\
+			return pairs;												\
+		}																\
+		for (i = 0; i < iterations; i++)								\
+			body(pointer, 1, yield);									\
+		for (i = 0; i < iterations; i++)								\
+			body(pointer, -1, yield);									\
+		return iterations;												\
 	}
 
-	prev = *pointer;
-	sum = *pointer + value;
+#define DEFINE_ADD(name, body)					\
+	DEFINE_ADD_VARIANT(name, body, 0)			\
+	DEFINE_ADD_VARIANT(name##_yield, body, 1)
+
+DEFINE_ADD(none, ADD_NONE)
+DEFINE_ADD(mutex, ADD_MUTEX)
+DEFINE_ADD(spin, ADD_SPIN)
+DEFINE_ADD(ttas, ADD_TTAS)
+DEFINE_ADD(futex, ADD_FUTEX)
+DEFINE_ADD(ticket, ADD_TICKET)
+DEFINE_ADD(mcs, ADD_MCS)
+DEFINE_ADD(clh, ADD_CLH)
+DEFINE_ADD(cas, ADD_CAS)
+DEFINE_ADD(seq_cst, ADD_SEQ_CST)
+DEFINE_ADD(acq_rel, ADD_ACQ_REL)
+DEFINE_ADD(relaxed, ADD_RELAXED)
+DEFINE_ADD(combine, ADD_COMBINE)
+
+// Generated variants for each --sync letter, without and with --yield
+struct add_variant {
+	char method;
+	void (*add)(long long *pointer, long long value);
+	long long (*run)(long long *pointer, int iterations);
+	void (*add_yield)(long long *pointer, long long value);
+	long long (*run_yield)(long long *pointer, int iterations);
+};
+
+#define ADD_VARIANT(method, name) \
+	{method, add_##name, run_##name, add_##name##_yield, run_##name##_yield}
 
-	if (opt_yield)
-		sched_yield();
+const struct add_variant add_variants[] = {
+	ADD_VARIANT('m', mutex),
+	ADD_VARIANT('s', spin),
+	ADD_VARIANT('b', ttas),
+	ADD_VARIANT('p', futex),
+	ADD_VARIANT('t', ticket),
+	ADD_VARIANT('q', mcs),
+	ADD_VARIANT('k', clh),
+	ADD_VARIANT('c', cas),
+	ADD_VARIANT('f', seq_cst),
+	ADD_VARIANT('a', acq_rel),
+	ADD_VARIANT('r', relaxed),
+	ADD_VARIANT('o', combine),
+	ADD_VARIANT(0, none)
+};
 
-	*pointer = sum;
+// Chosen once per run by select_add
+void (*add)(long long *pointer, long long value) = add_none;
+long long (*run_adds)(long long *pointer, int iterations) = run_none;
 
-	if (sync_method && *sync_method == 's')
-		__sync_lock_release(&spin_lock);
+// Pick the variants for the current sync and yield settings
+// Unknown sync letters run unsynchronized, as they always have
+void select_add()
+{
+	char method = sync_method ? *sync_method : 0;
+	const struct add_variant* v = add_variants;
+	while (v->method != 0 && v->method != method)
+		v++;
 
-	if (sync_method && *sync_method == 'm')
-		pthread_mutex_unlock(&mutexsum);
+	add = opt_yield ? v->add_yield : v->add;
+	run_adds = opt_yield ? v->run_yield : v->run;
 }
 
 // INPUT: Name of sys call that threw error
@@ -73,6 +492,387 @@ void process_failed_sys_call(const char syscall[])
 	exit(ERR_CODE);
 }
 
+// INPUT: Number of bytes to allocate
+// Return zero filled memory starting on a cache line, for arrays of
+// structs that are padded to cache lines so they never share one
+void* alloc_cache_aligned(size_t size)
+{
+	void* mem;
+	if (posix_memalign(&mem, 64, size) != 0)
+	{
+		process_failed_sys_call("posix_memalign");
+	}
+	memset(mem, 0, size);
+	return mem;
+}
+
+// INPUT: CPU number, name of a sysfs topology attribute
+// Return the attribute's value, or -1 if it is not available
+int read_cpu_topology(int cpu, const char* attr)
+{
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, attr);
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+		return -1;
+
+	int value = -1;
+	if (fscanf(file, "%d", &value) != 1)
+		value = -1;
+	fclose(file);
+	return value;
+}
+
+// Return the NUMA node a CPU belongs to, 0 if unknown
+int cpu_node(int cpu)
+{
+	char path[128];
+	int node;
+	for (node = 0; node < MAX_NODES; node++)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+		if (access(path, F_OK) == 0)
+			return node;
+	}
+	return 0;
+}
+
+// Compact: fill the hardware threads of a core, then cores, then packages
+int compare_compact(const void* a, const void* b)
+{
+	const struct cpu_place* x = (const struct cpu_place *) a;
+	const struct cpu_place* y = (const struct cpu_place *) b;
+	if (x->package != y->package)
+		return x->package - y->package;
+	if (x->core != y->core)
+		return x->core - y->core;
+	if (x->sibling != y->sibling)
+		return x->sibling - y->sibling;
+	return x->cpu - y->cpu;
+}
+
+// Scatter: round-robin across packages, then cores, then hardware threads
+int compare_scatter(const void* a, const void* b)
+{
+	const struct cpu_place* x = (const struct cpu_place *) a;
+	const struct cpu_place* y = (const struct cpu_place *) b;
+	if (x->sibling != y->sibling)
+		return x->sibling - y->sibling;
+	if (x->core != y->core)
+		return x->core - y->core;
+	if (x->package != y->package)
+		return x->package - y->package;
+	return x->cpu - y->cpu;
+}
+
+// INPUT: compact, scatter or a CPU list such as 0,2,4-7, and thread count
+// Return the CPU each thread is pinned to, wrapping when threads > CPUs
+int* plan_affinity(const char* spec, int threads)
+{
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+	{
+		process_failed_sys_call("sched_getaffinity");
+	}
+
+	struct cpu_place* places = (struct cpu_place *) malloc(sizeof(struct cpu_place) * CPU_SETSIZE);
+	int* plan = (int *) malloc(sizeof(int) * threads);
+	if (places == NULL || plan == NULL)
+	{
+		process_failed_sys_call("malloc");
+	}
+
+	int num_cpus = 0;
+	int cpu;
+	if (strcmp(spec, "compact") == 0 || strcmp(spec, "scatter") == 0)
+	{
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (!CPU_ISSET(cpu, &allowed))
+				continue;
+
+			places[num_cpus].cpu = cpu;
+			places[num_cpus].package = read_cpu_topology(cpu, "physical_package_id");
+			places[num_cpus].core = read_cpu_topology(cpu, "core_id");
+
+			// Number this CPU among the hardware threads of its core
+			places[num_cpus].sibling = 0;
+			int k;
+			for (k = 0; k < num_cpus; k++)
+			{
+				if (places[k].package == places[num_cpus].package &&
+					places[k].core == places[num_cpus].core)
+					places[num_cpus].sibling++;
+			}
+			num_cpus++;
+		}
+
+		qsort(places, num_cpus, sizeof(struct cpu_place),
+			  *spec == 'c' ? compare_compact : compare_scatter);
+	}
+	else
+	{
+		const char* p = spec;
+		while (*p)
+		{
+			char* end;
+			int first = strtol(p, &end, 10);
+			int last = first;
+			if (end == p)
+				break;
+			if (*end == '-')
+			{
+				p = end + 1;
+				last = strtol(p, &end, 10);
+				if (end == p)
+					break;
+			}
+			for (cpu = first; cpu <= last && num_cpus < CPU_SETSIZE; cpu++)
+			{
+				if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))
+				{
+					fprintf(stderr, "ERROR: CPU %d is not available to this process.\n", cpu);
+					exit(ERR_CODE);
+				}
+				places[num_cpus++].cpu = cpu;
+			}
+			p = end;
+			if (*p == ',')
+				p++;
+			else
+				break;
+		}
+
+		if (*p || num_cpus == 0)
+		{
+			fprintf(stderr, "ERROR: Invalid affinity '%s'.\n", spec);
+			fprintf(stderr, "%s\n", "Use compact, scatter or a CPU list such as 0,2,4-7.");
+			exit(ERR_CODE);
+		}
+	}
+
+	int i;
+	for (i = 0; i < threads; i++)
+	{
+		plan[i] = places[i % num_cpus].cpu;
+	}
+	free(places);
+	return plan;
+}
+
+// Spread all further allocations of this process across every NUMA node
+void interleave_memory()
+{
+	unsigned long mask = 0;
+	char path[64];
+	int node;
+	for (node = 0; node < MAX_NODES; node++)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+		if (access(path, F_OK) == 0)
+			mask |= 1UL << node;
+	}
+
+	if (syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8) == -1)
+	{
+		process_failed_sys_call("set_mempolicy");
+	}
+}
+
+// INPUT: Number of bytes, NUMA node to place them on
+// Return zeroed, page aligned memory; release it with munmap
+void* alloc_on_node(size_t size, int node)
+{
+	void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+	{
+		process_failed_sys_call("mmap");
+	}
+
+	unsigned long mask = 1UL << node;
+	if (syscall(SYS_mbind, mem, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) == -1)
+	{
+		process_failed_sys_call("mbind");
+	}
+	return mem;
+}
+
+// INPUT: Start and end of an interval
+// Return the elapsed time in nanoseconds
+long long get_time_dif(struct timespec starting, struct timespec ending)
+{
+	return (ending.tv_sec - starting.tv_sec) * 1000000000LL +
+		   (ending.tv_nsec - starting.tv_nsec);
+}
+
+// Map a latency to its bucket, exact below HIST_SUB_COUNT ns and
+// within 1 / HIST_SUB_COUNT relative error above
+int hist_index(long long value)
+{
+	if (value < HIST_SUB_COUNT)
+		return value < 0 ? 0 : value;
+
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - HIST_SUB_BITS;
+	return ((shift + 1) << HIST_SUB_BITS) + (int)((value >> shift) - HIST_SUB_COUNT);
+}
+
+// Return the midpoint of the values that map to a bucket
+long long hist_value(int index)
+{
+	if (index < HIST_SUB_COUNT)
+		return index;
+
+	int shift = (index >> HIST_SUB_BITS) - 1;
+	long long sub = (index & (HIST_SUB_COUNT - 1)) + HIST_SUB_COUNT;
+	return (sub << shift) + ((1LL << shift) >> 1);
+}
+
+void hist_record(struct latency_hist* hist, long long value)
+{
+	hist->buckets[hist_index(value)]++;
+	hist->count++;
+}
+
+void hist_merge(struct latency_hist* into, struct latency_hist* from)
+{
+	int i;
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		into->buckets[i] += from->buckets[i];
+	}
+	into->count += from->count;
+}
+
+// INPUT: Histogram and a fraction between 0 and 1
+// Return the latency below which that fraction of samples fall
+long long hist_percentile(struct latency_hist* hist, double fraction)
+{
+	long long target = (long long)(fraction * hist->count + 0.5);
+	if (target < 1)
+		target = 1;
+
+	long long seen = 0;
+	int i;
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		seen += hist->buckets[i];
+		if (seen >= target)
+			return hist_value(i);
+	}
+	return 0;
+}
+
+// INPUT: Array for one file descriptor per counter
+// Open this thread's hardware counters, disabled until perf_start
+// A counter the hardware or kernel does not offer is left at -1
+void perf_open(int* fds)
+{
+	struct perf_event_attr attr;
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.disabled = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		if (i == PERF_CYCLES)
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		else if (i == PERF_INSTRUCTIONS)
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		else if (i == PERF_LLC_MISSES)
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		else
+		{
+			// There is no generic event for snoop hits on modified lines,
+			// so transfers are only counted when the raw code is given
+			fds[i] = -1;
+			if (perf_raw_transfers == 0)
+				continue;
+			attr.type = PERF_TYPE_RAW;
+			attr.config = perf_raw_transfers;
+		}
+
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+		// Unprivileged users may only count user space
+		if (fds[i] == -1 && (errno == EACCES || errno == EPERM))
+		{
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+	}
+}
+
+// Reset and start every counter opened by perf_open
+void perf_start(int* fds)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (fds[i] != -1)
+		{
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+// INPUT: Counters from perf_open, where to store their values
+// Stop and close the counters, scaling for time lost to multiplexing
+void perf_stop(int* fds, struct perf_counts* counts)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		counts->value[i] = -1;
+		if (fds[i] == -1)
+			continue;
+
+		ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		// value, time enabled, time running
+		unsigned long long data[3];
+		if (read(fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0)
+		{
+			counts->value[i] = (long long) ((double) data[0] * data[1] / data[2]);
+		}
+		close(fds[i]);
+	}
+}
+
+// Add the counts of one thread into a total, a counter missing in
+// either stays missing
+void perf_merge(struct perf_counts* into, struct perf_counts* from)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (into->value[i] == -1 || from->value[i] == -1)
+			into->value[i] = -1;
+		else
+			into->value[i] += from->value[i];
+	}
+}
+
+// INPUT: Summed counts and the number of operations they cover
+// Print the counts per operation as CSV columns, NA for missing counters
+void perf_print(struct perf_counts* counts, long long operations)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (counts->value[i] == -1)
+			printf(",NA");
+		else
+			printf(",%.3f", (double) counts->value[i] / operations);
+	}
+}
+
 // INPUT: Info about CL arguments, strings for argument parameters
 // Process CL arguments while checking for invalid options
 void process_cl_arugments(int argc, char** argv,
@@ -84,6 +884,17 @@ void process_cl_arugments(int argc, char** argv,
 		{"iterations", required_argument, NULL, 'i'},
 		{"yield", no_argument, NULL, 'y'},
 		{"sync", required_argument, NULL, 's'},
+		{"backoff", required_argument, NULL, 'b'},
+		{"spin", required_argument, NULL, 'p'},
+		{"latency", no_argument, NULL, 'L'},
+		{"affinity", required_argument, NULL, 'a'},
+		{"numa", required_argument, NULL, 'n'},
+		{"duration", required_argument, NULL, 'd'},
+		{"sweep", no_argument, NULL, 'S'},
+		{"reps", required_argument, NULL, 'r'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"perf", optional_argument, NULL, 'P'},
+		{"batch", required_argument, NULL, 'B'},
 		{0, 0, 0, 0}
 	};
 	int option_index = 0;
@@ -110,28 +921,254 @@ void process_cl_arugments(int argc, char** argv,
 			case 's':
 				*sync = optarg;
 				break;
+			case 'b':
+				backoff_cap = atoi(optarg);
+				break;
+			case 'p':
+				spin_limit = atoi(optarg);
+				break;
+			case 'L':
+				opt_latency = 1;
+				break;
+			case 'a':
+				affinity = optarg;
+				break;
+			case 'd':
+				duration = atof(optarg);
+				break;
+			case 'S':
+				opt_sweep = 1;
+				break;
+			case 'r':
+				sweep_reps = atoi(optarg);
+				break;
+			case 'w':
+				sweep_warmup = atoi(optarg);
+				break;
+			case 'B':
+				batch_size = atoi(optarg);
+				if (batch_size < 1)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --batch must be at least 1.");
+					exit(ERR_CODE);
+				}
+				break;
+			case 'P':
+				opt_perf = 1;
+				if (optarg)
+					perf_raw_transfers = strtoull(optarg, NULL, 0);
+				break;
+			case 'n':
+				numa_policy = optarg;
+				if (strcmp(numa_policy, "local") != 0 && strcmp(numa_policy, "interleave") != 0)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --numa must be local or interleave.");
+					exit(ERR_CODE);
+				}
+				break;
 			case '?':
 				fprintf(stderr, "%s\n", "ERROR: Invalid argument.");
-				fprintf(stderr, "%s\n", "Usage: lab2a_add [--threads=#] [--iterations=#] [--yield] [--sync=[smc]]");
+				fprintf(stderr, "%s\n", "Usage: lab2a_add [--threads=#] [--iterations=#] [--yield] [--sync=[smcfartqkbpo]] [--backoff=#] [--spin=#] [--latency] [--affinity=compact|scatter|#,#-#] [--numa=local|interleave] [--duration=#] [--sweep [--reps=#] [--warmup=#]] [--perf[=raw]] [--batch=#]");
 				exit(ERR_CODE);
 		}
 	}
 }
 
+// INPUT: Buffer for the name, its size, length so far, format and values
+// Append to a test name, stopping once the buffer is full
+void append_name(char* name, size_t size, size_t* n, const char* format, ...)
+{
+	if (*n >= size)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(name + *n, size - *n, format, args);
+	va_end(args);
+	if (written > 0)
+		*n += written;
+}
+
+// INPUT: Buffer for the name and its size
+// Build the name of the test from the current yield and sync settings
+void build_test_name(char* name, size_t size)
+{
+	size_t n = 0;
+	append_name(name, size, &n, "add-%s%s", opt_yield ? "yield-" : "",
+				sync_method ? sync_method : "none");
+
+	// Batched runs get their own series
+	if (batch_size > 1)
+		append_name(name, size, &n, "-batch%d", batch_size);
+}
+
+// Two-sided 95% Student t critical value for the degrees of freedom
+double t_critical(int df)
+{
+	static const double table[] = {
+		0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	if (df < 1)
+		return 0;
+	if (df <= 30)
+		return table[df];
+	return 1.960;
+}
+
+// INPUT: Samples, how many there are, where to store their mean
+// Return the half width of the 95% confidence interval of the mean
+double confidence_interval(double* samples, int n, double* mean)
+{
+	double sum = 0;
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		sum += samples[i];
+	}
+	*mean = sum / n;
+
+	if (n < 2)
+		return 0;
+
+	double squares = 0;
+	for (i = 0; i < n; i++)
+	{
+		squares += (samples[i] - *mean) * (samples[i] - *mean);
+	}
+	return t_critical(n - 1) * sqrt(squares / (n - 1)) / sqrt(n);
+}
+
+// INPUT: Comma separated numbers or ranges such as 1,2,4-8
+// Fill values from the list and return how many there are
+int parse_int_list(const char* str, int* values)
+{
+	int n = 0;
+	const char* p = str;
+	while (*p && n < MAX_SWEEP)
+	{
+		char* end;
+		int first = strtol(p, &end, 10);
+		int last = first;
+		if (*end == '-')
+			last = strtol(end + 1, &end, 10);
+
+		int v;
+		for (v = first; v <= last && n < MAX_SWEEP; v++)
+		{
+			values[n++] = v;
+		}
+
+		p = end;
+		if (*p != ',')
+			break;
+		p++;
+	}
+	return n;
+}
+
 // INPUT: Information about test that was just run
 // Print to STDOUT a CSV record about test
+// With --sweep, ci holds the 95% interval for the run time and time / operation
 void print_results(char test_name[], int threads, int iterations,
-				   long starting_time, long ending_time, long long counter)
+				   long long total_operations, long long total_run_time,
+				   long long counter, struct latency_hist* hist,
+				   struct perf_counts* perf, double* ci)
 {
-	long total_operations = threads * iterations * 2;
-	long total_run_time = ending_time - starting_time;
-	long avg_time_per_operation = total_run_time / total_operations;
+	long long avg_time_per_operation = total_run_time / total_operations;
 
 	// name of test, # threads, # iterations, # operations, run time, time / operation, counter
 	printf("%s%c", test_name, ',');
 	printf("%d%c%d%c", threads, ',', iterations, ',');
-	printf("%ld%c%ld%c", total_operations, ',', total_run_time, ',');
-	printf("%ld%c%lld\n", avg_time_per_operation, ',', counter);
+	printf("%lld%c%lld%c", total_operations, ',', total_run_time, ',');
+	printf("%lld%c%lld", avg_time_per_operation, ',', counter);
+
+	// With --latency: add p50, p99, p99.9
+	if (hist)
+	{
+		printf(",%lld,%lld,%lld", hist_percentile(hist, 0.50),
+			   hist_percentile(hist, 0.99), hist_percentile(hist, 0.999));
+	}
+
+	// With --perf: cycles, instructions, LLC misses, transfers per operation
+	if (perf)
+		perf_print(perf, total_operations);
+
+	if (ci)
+	{
+		printf(",%.0f,%.2f", ci[0], ci[1]);
+	}
+	printf("\n");
+}
+
+// Call add, recording its latency for --latency
+void timed_add(long long *pointer, long long value)
+{
+	struct timespec starting, ending;
+	clock_gettime(CLOCK_MONOTONIC, &starting);
+	add(pointer, value);
+	clock_gettime(CLOCK_MONOTONIC, &ending);
+	hist_record(&hists[my_index], get_time_dif(starting, ending));
+}
+
+// Thread-local batch for --batch
+struct add_batch {
+	long long sum;
+	int pending;
+};
+
+// INPUT: Counter, batch, value to add, how to publish the batch
+// Add the value locally and publish the batch once it is full
+void batch_add(long long *pointer, struct add_batch* batch, long long value,
+			   void (*publish)(long long *pointer, long long value))
+{
+	batch->sum += value;
+	if (++batch->pending == batch_size)
+	{
+		publish(pointer, batch->sum);
+		batch->sum = 0;
+		batch->pending = 0;
+	}
+}
+
+// INPUT: Counter to update, iterations per thread
+// With --batch, accumulate batch_size adds locally and publish them with
+// one synchronized add, flushing whatever is left over at the end
+// Returns the number of add/subtract pairs done
+long long run_batched(long long *pointer, int iterations)
+{
+	void (*publish)(long long *pointer, long long value) = opt_latency ? timed_add : add;
+	struct add_batch batch = {0, 0};
+	long long pairs = 0;
+
+	if (duration > 0)
+	{
+		while (!__atomic_load_n(&stop_flag, __ATOMIC_RELAXED))
+		{
+			batch_add(pointer, &batch, 1, publish);
+			batch_add(pointer, &batch, -1, publish);
+			pairs++;
+		}
+	}
+	else
+	{
+		int i;
+		for (i = 0; i < iterations; i++)
+		{
+			batch_add(pointer, &batch, 1, publish);
+		}
+
+		for (i = 0; i < iterations; i++)
+		{
+			batch_add(pointer, &batch, -1, publish);
+		}
+		pairs = iterations;
+	}
+
+	if (batch.pending > 0)
+		publish(pointer, batch.sum);
+	return pairs;
 }
 
 // INPUT: Struct containing arguments
@@ -143,56 +1180,176 @@ void* add_wrapper(void *args)
 
 	int iter = my_args->iterations;
 
-	int i;
-	for (i = 0; i < iter; i++)
+	my_index = __sync_fetch_and_add(&next_thread_index, 1);
+	if (sync_method && *sync_method == 'k')
+		clh_me = &clh_nodes[my_index + 1];
+
+	int perf_fds[NUM_PERF];
+	if (opt_perf)
+		perf_open(perf_fds);
+
+	// Wait until every thread exists so none starts out uncontended,
+	// then again for main to start the clock and release everyone
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&start_barrier);
+
+	if (opt_perf)
+		perf_start(perf_fds);
+
+	if (batch_size > 1)
 	{
-		add(my_args->counter, 1);
+		thread_pairs[my_index] = run_batched(my_args->counter, iter);
 	}
-
-	for (i = 0; i < iter; i++)
+	// Without --latency the whole loop is the generated variant
+	else if (!opt_latency)
 	{
-		add(my_args->counter, -1);
+		thread_pairs[my_index] = run_adds(my_args->counter, iter);
 	}
+	// With --duration, add and subtract until main raises the stop flag
+	else if (duration > 0)
+	{
+		long long pairs = 0;
+		while (!__atomic_load_n(&stop_flag, __ATOMIC_RELAXED))
+		{
+			timed_add(my_args->counter, 1);
+			timed_add(my_args->counter, -1);
+			pairs++;
+		}
+		thread_pairs[my_index] = pairs;
+	}
+	else
+	{
+		int i;
+		for (i = 0; i < iter; i++)
+		{
+			timed_add(my_args->counter, 1);
+		}
+
+		for (i = 0; i < iter; i++)
+		{
+			timed_add(my_args->counter, -1);
+		}
+	}
+
+	if (opt_perf)
+		perf_stop(perf_fds, &thread_perf[my_index]);
 	pthread_exit(NULL);
 }
 
-int main(int argc, char** argv)
+// INPUT: Thread and iteration counts, histogram to merge latencies into
+// Run the test once with the current sync settings and measure it
+void run_test(int num_threads, int num_iterations, struct latency_hist* total_hist,
+			  struct run_result* result)
 {
-	// Default both values to 1
-	char def_value[2] = {'1'};
-	char* str_threads = def_value;
-	char* str_iterations = def_value;
-	opt_yield = 0;
-	sync_method = NULL;
-	process_cl_arugments(argc, argv, &str_threads, &str_iterations, &sync_method);
-
 	long long counter = 0;
-	int num_threads = atoi(str_threads);
-	int num_iterations = atoi(str_iterations);
+	next_thread_index = 0;
+	stop_flag = 0;
+	select_add();
+
+	// Local placement only makes sense for pinned threads
+	if (numa_policy && *numa_policy == 'l' && affinity == NULL)
+		affinity = "compact";
+	if (affinity)
+		thread_cpu = plan_affinity(affinity, num_threads);
+
+	// The counter lives on the node of the first thread with --numa=local
+	long long* shared_counter = &counter;
+	if (numa_policy && *numa_policy == 'l')
+		shared_counter = (long long*) alloc_on_node(sizeof(long long), cpu_node(thread_cpu[0]));
 
 	// Initialize any synchronization methods
 	if (sync_method)
 		pthread_mutex_init(&mutexsum, NULL);
 
-	struct timespec starting;
-	if (clock_gettime(CLOCK_REALTIME, &starting) == -1)
+	// One CLH node per thread plus the initial unlocked tail
+	if (sync_method && *sync_method == 'k')
 	{
-		process_failed_sys_call("clock_gettime");
+		clh_nodes = (struct clh_node*) alloc_cache_aligned((num_threads + 1) * sizeof(struct clh_node));
+		clh_sum.tail = &clh_nodes[0];
+	}
+
+	if (sync_method && *sync_method == 'o')
+	{
+		num_slots = num_threads;
+		fc_slots = (struct fc_slot*) alloc_cache_aligned(num_slots * sizeof(struct fc_slot));
+	}
+
+	// Per thread histograms, merged into the caller's after join
+	if (opt_latency)
+	{
+		hists = (struct latency_hist*) calloc(num_threads, sizeof(struct latency_hist));
+		if (hists == NULL)
+		{
+			process_failed_sys_call("calloc");
+		}
+	}
+
+	thread_pairs = (long long*) calloc(num_threads, sizeof(long long));
+	if (thread_pairs == NULL)
+	{
+		process_failed_sys_call("calloc");
+	}
+
+	if (opt_perf)
+	{
+		thread_perf = (struct perf_counts*) calloc(num_threads, sizeof(struct perf_counts));
+		if (thread_perf == NULL)
+		{
+			process_failed_sys_call("calloc");
+		}
+	}
+
+	// Main joins the start barrier so it can time from the moment all
+	// threads are ready until the last one is joined
+	if (pthread_barrier_init(&start_barrier, NULL, num_threads + 1) != 0)
+	{
+		process_failed_sys_call("pthread_barrier_init");
 	}
 
 	pthread_t* threads = (pthread_t*) malloc(sizeof(pthread_t) * num_threads);
 
 	struct thread_args args;
-	args.counter = &counter;
+	args.counter = shared_counter;
 	args.iterations = num_iterations;
 
 	long i;
 	for (i = 0; i < num_threads; i++)
 	{
-		if (pthread_create(&threads[i], NULL, add_wrapper, (void *)&args) != 0)
+		// Pin through the attributes so the thread never runs elsewhere
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		if (thread_cpu)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(thread_cpu[i], &cpus);
+			pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+		}
+
+		if (pthread_create(&threads[i], &attr, add_wrapper, (void *)&args) != 0)
 		{
 			process_failed_sys_call("pthread_create");
 		}
+		pthread_attr_destroy(&attr);
+	}
+
+	pthread_barrier_wait(&start_barrier);
+
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	pthread_barrier_wait(&start_barrier);
+
+	if (duration > 0)
+	{
+		struct timespec run_for;
+		run_for.tv_sec = (time_t) duration;
+		run_for.tv_nsec = (long) ((duration - run_for.tv_sec) * 1000000000);
+		while (nanosleep(&run_for, &run_for) == -1 && errno == EINTR);
+		__atomic_store_n(&stop_flag, 1, __ATOMIC_RELAXED);
 	}
 
 	void* status;
@@ -205,48 +1362,204 @@ int main(int argc, char** argv)
 	}
 
 	free(threads);
+	free(clh_nodes);
+	free(fc_slots);
+	clh_nodes = NULL;
+	fc_slots = NULL;
 
 	struct timespec ending;
-	if (clock_gettime(CLOCK_REALTIME, &ending) == -1)
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
 	{
 		process_failed_sys_call("clock_gettime");
 	}
 
-	if (opt_yield)
+	long long run_time = get_time_dif(starting, ending);
+
+	// Timed runs report the average number of iterations each thread did
+	long long total_operations = (long long) num_threads * num_iterations * 2;
+	if (duration > 0)
 	{
-		if (sync_method)
+		long long pairs = 0;
+		for (i = 0; i < num_threads; i++)
 		{
-			char output_str[12] = {"add-yield-"};
-			output_str[10] = *sync_method;
+			pairs += thread_pairs[i];
+		}
+		total_operations = pairs * 2;
+		num_iterations = pairs / num_threads;
+	}
+	free(thread_pairs);
+	pthread_barrier_destroy(&start_barrier);
+
+	if (shared_counter != &counter)
+	{
+		counter = *shared_counter;
+		munmap(shared_counter, sizeof(long long));
+	}
+	free(thread_cpu);
+	thread_cpu = NULL;
 
-			print_results(output_str, num_threads, num_iterations,
-				  	  	  starting.tv_nsec, ending.tv_nsec, counter);
+	if (total_hist)
+	{
+		for (i = 0; i < num_threads; i++)
+		{
+			hist_merge(total_hist, &hists[i]);
 		}
-		else
+	}
+	free(hists);
+	hists = NULL;
+
+	memset(&result->perf, 0, sizeof(result->perf));
+	if (opt_perf)
+	{
+		for (i = 0; i < num_threads; i++)
 		{
-			print_results("add-yield-none", num_threads, num_iterations,
-				  	  	  starting.tv_nsec, ending.tv_nsec, counter);
+			perf_merge(&result->perf, &thread_perf[i]);
 		}
 	}
-	else
+	free(thread_perf);
+	thread_perf = NULL;
+
+	result->iterations = num_iterations;
+	result->operations = total_operations;
+	result->run_time = run_time;
+	result->counter = counter;
+}
+
+// INPUT: Comma separated thread counts, iteration counts and sync methods
+// Run every combination after a warmup and print one record per combination
+// with the mean of the repetitions and 95% confidence intervals
+void run_sweep(char* str_threads, char* str_iterations, char* str_sync)
+{
+	int thread_values[MAX_SWEEP];
+	int iteration_values[MAX_SWEEP];
+	int num_thread_values = parse_int_list(str_threads, thread_values);
+	int num_iteration_values = parse_int_list(str_iterations, iteration_values);
+
+	// Split the sync methods, "none" runs without synchronization
+	char* sync_values[MAX_SWEEP];
+	int num_sync_values = 0;
+	char* sync_copy = strdup(str_sync ? str_sync : "none");
+	char* token = strtok(sync_copy, ",");
+	while (token && num_sync_values < MAX_SWEEP)
+	{
+		sync_values[num_sync_values++] = strcmp(token, "none") == 0 ? NULL : token;
+		token = strtok(NULL, ",");
+	}
+
+	if (sweep_reps < 1)
+		sweep_reps = 1;
+
+	double* run_times = (double*) malloc(sizeof(double) * sweep_reps);
+	double* op_times = (double*) malloc(sizeof(double) * sweep_reps);
+	struct latency_hist* hist = NULL;
+	if (opt_latency)
+		hist = (struct latency_hist*) malloc(sizeof(struct latency_hist));
+	if (run_times == NULL || op_times == NULL || (opt_latency && hist == NULL))
 	{
-		if (sync_method)
+		process_failed_sys_call("malloc");
+	}
+
+	int s, t, it, rep;
+	for (s = 0; s < num_sync_values; s++)
+	{
+		sync_method = sync_values[s];
+		for (t = 0; t < num_thread_values; t++)
 		{
-			char output_str[6] = {"add-"};
-			output_str[4] = *sync_method;
+			for (it = 0; it < num_iteration_values; it++)
+			{
+				struct run_result result;
+				for (rep = 0; rep < sweep_warmup; rep++)
+				{
+					run_test(thread_values[t], iteration_values[it], NULL, &result);
+				}
+
+				if (hist)
+					memset(hist, 0, sizeof(struct latency_hist));
+
+				long long operations = 0;
+				struct perf_counts perf;
+				memset(&perf, 0, sizeof(perf));
+				for (rep = 0; rep < sweep_reps; rep++)
+				{
+					run_test(thread_values[t], iteration_values[it], hist, &result);
+					run_times[rep] = result.run_time;
+					op_times[rep] = (double) result.run_time / result.operations;
+					operations += result.operations;
+					perf_merge(&perf, &result.perf);
+				}
 
-			print_results(output_str, num_threads, num_iterations,
-				  	  	  starting.tv_nsec, ending.tv_nsec, counter);
+				// Per operation counts cover every repetition
+				int i;
+				for (i = 0; i < NUM_PERF; i++)
+				{
+					if (perf.value[i] != -1)
+						perf.value[i] /= sweep_reps;
+				}
 
+				double run_time;
+				double op_time;
+				double ci[2];
+				ci[0] = confidence_interval(run_times, sweep_reps, &run_time);
+				ci[1] = confidence_interval(op_times, sweep_reps, &op_time);
+
+				char name[64];
+				build_test_name(name, sizeof(name));
+				print_results(name, thread_values[t], result.iterations,
+							  operations / sweep_reps, (long long) run_time,
+							  result.counter, hist, opt_perf ? &perf : NULL, ci);
+				fflush(stdout);
+			}
 		}
-		else
+	}
+
+	free(run_times);
+	free(op_times);
+	free(hist);
+	free(sync_copy);
+}
+
+int main(int argc, char** argv)
+{
+	// Default both values to 1
+	char def_value[2] = {'1'};
+	char* str_threads = def_value;
+	char* str_iterations = def_value;
+	opt_yield = 0;
+	sync_method = NULL;
+	process_cl_arugments(argc, argv, &str_threads, &str_iterations, &sync_method);
+
+	if (numa_policy && *numa_policy == 'i')
+		interleave_memory();
+
+	if (opt_sweep)
+	{
+		run_sweep(str_threads, str_iterations, sync_method);
+		exit(SUCCESS_CODE);
+	}
+
+	int num_threads = atoi(str_threads);
+	int num_iterations = atoi(str_iterations);
+
+	struct latency_hist* hist = NULL;
+	if (opt_latency)
+	{
+		hist = (struct latency_hist*) calloc(1, sizeof(struct latency_hist));
+		if (hist == NULL)
 		{
-			print_results("add-none", num_threads, num_iterations,
-				  	  	  starting.tv_nsec, ending.tv_nsec, counter);
+			process_failed_sys_call("calloc");
 		}
 	}
 
+	struct run_result result;
+	run_test(num_threads, num_iterations, hist, &result);
+
+	char name[64];
+	build_test_name(name, sizeof(name));
+	print_results(name, num_threads, result.iterations, result.operations,
+				  result.run_time, result.counter, hist,
+				  opt_perf ? &result.perf : NULL, NULL);
+
+	free(hist);
 	pthread_exit(NULL);
 	exit(SUCCESS_CODE);
 }
-
@@ -0,0 +1,223 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "HandOverHandList.h"
+#include <string.h>
+#include <sched.h>
+
+// Elements are zero filled, which is an unlocked default mutex
+static inline void lock(SortedListElement_t *element)
+{
+	pthread_mutex_lock(&((HandOverHandNode_t *) element)->lock);
+}
+
+static inline void unlock(SortedListElement_t *element)
+{
+	pthread_mutex_unlock(&((HandOverHandNode_t *) element)->lock);
+}
+
+// prev is read before its lock is held, so it is always read and
+// written atomically
+static inline SortedListElement_t *load_prev(SortedListElement_t *element)
+{
+	return __atomic_load_n(&element->prev, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_prev(SortedListElement_t *element, SortedListElement_t *prev)
+{
+	__atomic_store_n(&element->prev, prev, __ATOMIC_RELEASE);
+}
+
+/**
+ * HandOverHandList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void HandOverHandList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	SortedListElement_t *prev = list;
+	lock(prev);
+	SortedListElement_t *curr = prev->next;
+	if (curr)
+	{
+		lock(curr);
+	}
+
+	// Find first node greater than or equal to element, holding the
+	// locks of the nodes on both sides of the gap
+	while (curr && strcmp(element->key, curr->key) > 0)
+	{
+		unlock(prev);
+		prev = curr;
+		curr = curr->next;
+		if (curr)
+		{
+			lock(curr);
+		}
+	}
+
+	if (opt_yield & INSERT_YIELD)
+	{
+		sched_yield();
+	}
+
+	store_prev(element, prev);
+	element->next = curr;
+	prev->next = element;
+	if (curr)
+	{
+		store_prev(curr, element);
+		unlock(curr);
+	}
+	unlock(prev);
+}
+
+/**
+ * HandOverHandList_delete ... remove an element from a sorted list
+ * @param SortedListElement_t *element ... element to be removed
+ * @return 0: element deleted successfully, 1: corrtuped prev/next pointers
+ */
+int HandOverHandList_delete(SortedListElement_t *element)
+{
+	if (element == NULL)
+	{
+		return 1;
+	}
+
+	// Lock the predecessor first to keep list order. Changing
+	// element->prev needs the old predecessor's lock, so once we
+	// hold it and it still matches, it is the real predecessor
+	SortedListElement_t *prev;
+	while (1)
+	{
+		prev = load_prev(element);
+		if (prev == NULL)
+		{
+			return 0;
+		}
+
+		lock(prev);
+		if (load_prev(element) == prev)
+		{
+			break;
+		}
+		unlock(prev);
+	}
+
+	lock(element);
+	SortedListElement_t *next = element->next;
+	if (next)
+	{
+		lock(next);
+	}
+
+	if (opt_yield & DELETE_YIELD)
+	{
+		sched_yield();
+	}
+
+	int err = 1;
+	if (prev->next == element && (next == NULL || next->prev == element))
+	{
+		prev->next = next;
+		if (next)
+		{
+			store_prev(next, prev);
+		}
+		store_prev(element, NULL);
+		element->next = NULL;
+		err = 0;
+	}
+
+	if (next)
+	{
+		unlock(next);
+	}
+	unlock(element);
+	unlock(prev);
+	return err;
+}
+
+/**
+ * HandOverHandList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *HandOverHandList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	SortedListElement_t *prev = list;
+	lock(prev);
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	SortedListElement_t *curr = prev->next;
+	while (curr)
+	{
+		lock(curr);
+		unlock(prev);
+
+		int cmp = strcmp(curr->key, key);
+		if (cmp >= 0)
+		{
+			unlock(curr);
+			return cmp == 0 ? curr : NULL;
+		}
+		prev = curr;
+		curr = curr->next;
+	}
+	unlock(prev);
+	return NULL;
+}
+
+/**
+ * HandOverHandList_length ... count elements in a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @return int number of elements in list (excluding head)
+ *	   -1 if the list is corrupted
+ */
+int HandOverHandList_length(SortedList_t *list)
+{
+	if (list == NULL)
+	{
+		return 0;
+	}
+
+	SortedListElement_t *prev = list;
+	lock(prev);
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	int count = 0;
+	SortedListElement_t *curr = prev->next;
+	while (curr)
+	{
+		lock(curr);
+
+		// Validate pointers while both ends of the link are held
+		if (curr->prev != prev)
+		{
+			unlock(curr);
+			unlock(prev);
+			return -1;
+		}
+		unlock(prev);
+
+		count++;
+		prev = curr;
+		curr = curr->next;
+	}
+	unlock(prev);
+	return count;
+}
@@ -0,0 +1,32 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef HANDOVERHANDLIST_H
+#define HANDOVERHANDLIST_H
+
+/**
+ * HandOverHandList (and HandOverHandNode)
+ *
+ *	The doubly linked list behind the SortedList interface with a
+ *	lock in every element. Traversals use lock coupling: the lock
+ *	of the next element is taken before the lock of the current one
+ *	is released, so threads working on different parts of one list
+ *	proceed in parallel. Locks are always taken in list order.
+ *
+ *	The list head is a HandOverHandNode too.
+ */
+#include "SortedList.h"
+#include <pthread.h>
+
+struct HandOverHandNode {
+	SortedListElement_t element;
+	pthread_mutex_t lock;
+};
+typedef struct HandOverHandNode HandOverHandNode_t;
+
+void HandOverHandList_insert(SortedList_t *list, SortedListElement_t *element);
+int HandOverHandList_delete(SortedListElement_t *element);
+SortedListElement_t *HandOverHandList_lookup(SortedList_t *list, const char *key);
+int HandOverHandList_length(SortedList_t *list);
+
+#endif
@@ -0,0 +1,127 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "InlineKeyList.h"
+#include <string.h>
+#include <sched.h>
+
+/**
+ * make_probe ... fill the inline fields for a key
+ *	Bytes past the end of the key are zero, so comparing prefixes as
+ *	integers and the inline bytes with memcmp orders keys like strcmp
+ * @param InlineKeyNode_t *probe ... node whose prefix and key are set
+ * @param const char * key ... the key
+ */
+static void make_probe(InlineKeyNode_t *probe, const char *key)
+{
+	int i;
+	for (i = 0; i < INLINE_KEY_LEN && key[i]; i++)
+	{
+		probe->key[i] = key[i];
+	}
+	for (; i < INLINE_KEY_LEN; i++)
+	{
+		probe->key[i] = 0;
+	}
+
+	uint64_t prefix = 0;
+	for (i = 0; i < 8; i++)
+	{
+		prefix = (prefix << 8) | (unsigned char) probe->key[i];
+	}
+	probe->prefix = prefix;
+}
+
+/**
+ * compare ... order two nodes by key
+ * @return <0, 0 or >0 as strcmp would for the two keys
+ */
+static inline int compare(const InlineKeyNode_t *a, const InlineKeyNode_t *b)
+{
+	if (a->prefix != b->prefix)
+	{
+		return a->prefix < b->prefix ? -1 : 1;
+	}
+	int cmp = memcmp(a->key, b->key, INLINE_KEY_LEN);
+	if (cmp != 0)
+	{
+		return cmp;
+	}
+	return strcmp(a->element.key, b->element.key);
+}
+
+/**
+ * InlineKeyList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void InlineKeyList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	InlineKeyNode_t *node = (InlineKeyNode_t *) element;
+	make_probe(node, element->key);
+
+	SortedListElement_t* prev = list;
+	SortedListElement_t* curr = prev->next;
+
+	// Find first node greater than or equal to element, insert before said node
+	while (curr && compare(node, (InlineKeyNode_t *) curr) > 0)
+	{
+		prev = curr;
+		curr = curr->next;
+	}
+
+	if (opt_yield & INSERT_YIELD)
+	{
+		sched_yield();
+	}
+
+	element->prev = prev;
+	element->next = curr;
+	prev->next = element;
+
+	// If not last element update curr, otherwise update head
+	if (curr)
+	{
+		curr->prev = element;
+	}
+}
+
+/**
+ * InlineKeyList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *InlineKeyList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	InlineKeyNode_t probe;
+	probe.element.key = key;
+	make_probe(&probe, key);
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	// The list is sorted, so stop at the first larger key
+	SortedListElement_t* curr = list->next;
+	while (curr)
+	{
+		int cmp = compare((InlineKeyNode_t *) curr, &probe);
+		if (cmp == 0)
+		{
+			return curr;
+		}
+		if (cmp > 0)
+		{
+			return NULL;
+		}
+		curr = curr->next;
+	}
+	return NULL;
+}
@@ -0,0 +1,36 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef INLINEKEYLIST_H
+#define INLINEKEYLIST_H
+
+/**
+ * InlineKeyList (and InlineKeyNode)
+ *
+ *	The linear list with a cache friendlier node layout. On insert
+ *	the first INLINE_KEY_LEN bytes of the key are copied into the
+ *	node, behind an 8 byte big-endian prefix of the key, so walking
+ *	the list compares integers held on the node's own cache line
+ *	instead of following key pointers into strcmp. Only keys that
+ *	match on all inline bytes fall back to strcmp, so keys longer
+ *	than INLINE_KEY_LEN still sort correctly.
+ *
+ *	Deletes and length checks only touch prev/next, so the linear
+ *	ones are used unchanged. The list head is an InlineKeyNode too.
+ */
+#include "SortedList.h"
+#include <stdint.h>
+
+#define INLINE_KEY_LEN 20
+
+struct InlineKeyNode {
+	SortedListElement_t element;
+	uint64_t prefix;
+	char key[INLINE_KEY_LEN];
+};
+typedef struct InlineKeyNode InlineKeyNode_t;
+
+void InlineKeyList_insert(SortedList_t *list, SortedListElement_t *element);
+SortedListElement_t *InlineKeyList_lookup(SortedList_t *list, const char *key);
+
+#endif
@@ -0,0 +1,231 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "LazyList.h"
+#include <string.h>
+#include <sched.h>
+
+// Elements are zero filled, which is an unlocked default mutex
+static inline void lock(SortedListElement_t *element)
+{
+	pthread_mutex_lock(&((LazyListNode_t *) element)->lock);
+}
+
+static inline void unlock(SortedListElement_t *element)
+{
+	pthread_mutex_unlock(&((LazyListNode_t *) element)->lock);
+}
+
+static inline int is_marked(SortedListElement_t *element)
+{
+	return __atomic_load_n(&((LazyListNode_t *) element)->marked, __ATOMIC_ACQUIRE);
+}
+
+static inline SortedListElement_t *load_next(SortedListElement_t *element)
+{
+	return __atomic_load_n(&element->next, __ATOMIC_ACQUIRE);
+}
+
+// prev is read before its lock is held, so it is always read and
+// written atomically
+static inline SortedListElement_t *load_prev(SortedListElement_t *element)
+{
+	return __atomic_load_n(&element->prev, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_prev(SortedListElement_t *element, SortedListElement_t *prev)
+{
+	__atomic_store_n(&element->prev, prev, __ATOMIC_RELEASE);
+}
+
+/**
+ * LazyList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void LazyList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	while (1)
+	{
+		// Find first node greater than or equal to element without locking
+		SortedListElement_t *prev = list;
+		SortedListElement_t *curr = load_next(prev);
+		while (curr && strcmp(element->key, curr->key) > 0)
+		{
+			prev = curr;
+			curr = load_next(curr);
+		}
+
+		lock(prev);
+		if (curr)
+		{
+			lock(curr);
+		}
+
+		if (opt_yield & INSERT_YIELD)
+		{
+			sched_yield();
+		}
+
+		int valid = !is_marked(prev) && prev->next == curr && (curr == NULL || !is_marked(curr));
+		if (valid)
+		{
+			store_prev(element, prev);
+			element->next = curr;
+			__atomic_store_n(&((LazyListNode_t *) element)->marked, 0, __ATOMIC_RELAXED);
+
+			// Publish the element only once it is fully set up
+			__atomic_store_n(&prev->next, element, __ATOMIC_RELEASE);
+			if (curr)
+			{
+				store_prev(curr, element);
+			}
+		}
+
+		if (curr)
+		{
+			unlock(curr);
+		}
+		unlock(prev);
+
+		if (valid)
+		{
+			return;
+		}
+	}
+}
+
+/**
+ * LazyList_delete ... remove an element from a sorted list
+ * @param SortedListElement_t *element ... element to be removed
+ * @return 0: element deleted successfully, 1: element was already deleted
+ */
+int LazyList_delete(SortedListElement_t *element)
+{
+	if (element == NULL)
+	{
+		return 1;
+	}
+
+	while (1)
+	{
+		// prev only changes while the old predecessor is locked, so
+		// it is checked again once both locks are held
+		SortedListElement_t *prev = load_prev(element);
+		if (prev == NULL)
+		{
+			return 1;
+		}
+
+		lock(prev);
+		lock(element);
+
+		if (opt_yield & DELETE_YIELD)
+		{
+			sched_yield();
+		}
+
+		if (is_marked(element))
+		{
+			unlock(element);
+			unlock(prev);
+			return 1;
+		}
+
+		if (!is_marked(prev) && load_prev(element) == prev && prev->next == element)
+		{
+			// Logical delete first, so readers ignore the element,
+			// then unlink it. Its next pointer stays intact
+			__atomic_store_n(&((LazyListNode_t *) element)->marked, 1, __ATOMIC_RELEASE);
+
+			SortedListElement_t *next = element->next;
+			__atomic_store_n(&prev->next, next, __ATOMIC_RELEASE);
+
+			// Only the holder of next->prev's lock changes next->prev
+			if (next)
+			{
+				store_prev(next, prev);
+			}
+
+			unlock(element);
+			unlock(prev);
+			return 0;
+		}
+
+		unlock(element);
+		unlock(prev);
+	}
+}
+
+/**
+ * LazyList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *LazyList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	SortedListElement_t *curr = load_next(list);
+	while (curr)
+	{
+		int cmp = strcmp(curr->key, key);
+		if (cmp > 0)
+		{
+			return NULL;
+		}
+		if (cmp == 0 && !is_marked(curr))
+		{
+			return curr;
+		}
+		curr = load_next(curr);
+	}
+	return NULL;
+}
+
+/**
+ * LazyList_length ... count elements in a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @return int number of live elements in list (excluding head)
+ *	   -1 if the list is out of order
+ */
+int LazyList_length(SortedList_t *list)
+{
+	if (list == NULL)
+	{
+		return 0;
+	}
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	// prev pointers may be mid-update without locks, so check ordering
+	int count = 0;
+	SortedListElement_t *prev = NULL;
+	SortedListElement_t *curr = load_next(list);
+	while (curr)
+	{
+		if (!is_marked(curr))
+		{
+			if (prev && strcmp(prev->key, curr->key) > 0)
+			{
+				return -1;
+			}
+			prev = curr;
+			count++;
+		}
+		curr = load_next(curr);
+	}
+	return count;
+}
@@ -0,0 +1,35 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef LAZYLIST_H
+#define LAZYLIST_H
+
+/**
+ * LazyList (and LazyListNode)
+ *
+ *	Heller et al. lazy list behind the SortedList interface.
+ *	Lookups and length scans take no locks. Inserts and deletes
+ *	find their place without locks, lock only the two nodes around
+ *	the change and then validate that neither is marked deleted and
+ *	that they are still adjacent, retrying if not. A delete sets
+ *	the marked flag before unlinking, and a deleted node keeps its
+ *	next pointer so readers standing on it can carry on.
+ *
+ *	The list head is a LazyListNode too.
+ */
+#include "SortedList.h"
+#include <pthread.h>
+
+struct LazyListNode {
+	SortedListElement_t element;
+	int marked;
+	pthread_mutex_t lock;
+};
+typedef struct LazyListNode LazyListNode_t;
+
+void LazyList_insert(SortedList_t *list, SortedListElement_t *element);
+int LazyList_delete(SortedListElement_t *element);
+SortedListElement_t *LazyList_lookup(SortedList_t *list, const char *key);
+int LazyList_length(SortedList_t *list);
+
+#endif
@@ -0,0 +1,214 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "LockFreeList.h"
+#include <string.h>
+#include <sched.h>
+
+// The low bit of next marks its element as deleted
+#define MARK ((size_t) 1)
+
+static inline int is_marked(SortedListElement_t *p)
+{
+	return ((size_t) p & MARK) != 0;
+}
+
+static inline SortedListElement_t *marked(SortedListElement_t *p)
+{
+	return (SortedListElement_t *) ((size_t) p | MARK);
+}
+
+static inline SortedListElement_t *unmarked(SortedListElement_t *p)
+{
+	return (SortedListElement_t *) ((size_t) p & ~MARK);
+}
+
+static inline SortedListElement_t *load_next(SortedListElement_t *element)
+{
+	return __atomic_load_n(&element->next, __ATOMIC_ACQUIRE);
+}
+
+static inline int swap_next(SortedListElement_t *element, SortedListElement_t *expected,
+							SortedListElement_t *desired)
+{
+	return __atomic_compare_exchange_n(&element->next, &expected, desired, 0,
+									   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * find ... locate where a key belongs, unlinking deleted elements
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the key being searched for
+ * @param int past_equal ... also walk past elements equal to the key
+ * @param SortedListElement_t **pred ... set to the element before the result
+ * @return first live element with a key greater than or equal to the key
+ *	   (greater than with past_equal), or NULL at the end of the list
+ */
+static SortedListElement_t *find(SortedList_t *list, const char *key, int past_equal,
+								 SortedListElement_t **pred)
+{
+retry:
+	*pred = list;
+	SortedListElement_t *curr = unmarked(load_next(list));
+	while (curr)
+	{
+		SortedListElement_t *succ = load_next(curr);
+		if (is_marked(succ))
+		{
+			// Unlink the deleted element, starting over if pred changed
+			if (!swap_next(*pred, curr, unmarked(succ)))
+			{
+				goto retry;
+			}
+			curr = unmarked(succ);
+			continue;
+		}
+
+		int cmp = strcmp(curr->key, key);
+		if (cmp > 0 || (cmp == 0 && !past_equal))
+		{
+			break;
+		}
+		*pred = curr;
+		curr = succ;
+	}
+	return curr;
+}
+
+/**
+ * LockFreeList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void LockFreeList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	element->prev = list;
+	while (1)
+	{
+		SortedListElement_t *pred;
+		SortedListElement_t *curr = find(list, element->key, 0, &pred);
+
+		if (opt_yield & INSERT_YIELD)
+		{
+			sched_yield();
+		}
+
+		element->next = curr;
+		if (swap_next(pred, curr, element))
+		{
+			return;
+		}
+	}
+}
+
+/**
+ * LockFreeList_delete ... remove an element from a sorted list
+ * @param SortedListElement_t *element ... element to be removed
+ * @return 0: element deleted successfully, 1: element was already deleted
+ */
+int LockFreeList_delete(SortedListElement_t *element)
+{
+	if (element == NULL || element->prev == NULL)
+	{
+		return 1;
+	}
+
+	// Logical delete: mark our next pointer so nothing links after us
+	SortedListElement_t *next = load_next(element);
+	do
+	{
+		if (is_marked(next))
+		{
+			return 1;
+		}
+
+		if (opt_yield & DELETE_YIELD)
+		{
+			sched_yield();
+		}
+	} while (!__atomic_compare_exchange_n(&element->next, &next, marked(next), 0,
+										  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	// Physical delete: walk past every element with our key so we are
+	// unlinked before returning and the caller may insert us again
+	SortedListElement_t *pred;
+	find(element->prev, element->key, 1, &pred);
+	element->prev = NULL;
+	return 0;
+}
+
+/**
+ * LockFreeList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *LockFreeList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	// Read only: skip over deleted elements instead of unlinking them
+	SortedListElement_t *curr = unmarked(load_next(list));
+	while (curr)
+	{
+		SortedListElement_t *succ = load_next(curr);
+		int cmp = strcmp(curr->key, key);
+		if (cmp > 0)
+		{
+			return NULL;
+		}
+		if (cmp == 0 && !is_marked(succ))
+		{
+			return curr;
+		}
+		curr = unmarked(succ);
+	}
+	return NULL;
+}
+
+/**
+ * LockFreeList_length ... count elements in a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @return int number of live elements in list (excluding head)
+ *	   -1 if the list is out of order
+ */
+int LockFreeList_length(SortedList_t *list)
+{
+	if (list == NULL)
+	{
+		return 0;
+	}
+
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	int count = 0;
+	SortedListElement_t *prev = NULL;
+	SortedListElement_t *curr = unmarked(load_next(list));
+	while (curr)
+	{
+		SortedListElement_t *succ = load_next(curr);
+		if (!is_marked(succ))
+		{
+			// Without prev pointers to check, check the ordering instead
+			if (prev && strcmp(prev->key, curr->key) > 0)
+			{
+				return -1;
+			}
+			prev = curr;
+			count++;
+		}
+		curr = unmarked(succ);
+	}
+	return count;
+}
@@ -0,0 +1,28 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef LOCKFREELIST_H
+#define LOCKFREELIST_H
+
+/**
+ * LockFreeList
+ *
+ *	Harris/Michael lock-free sorted list behind the SortedList
+ *	interface. The list is singly linked through next, and an
+ *	element is deleted by first setting the low bit of its own
+ *	next pointer, which stops any insert after it, and then
+ *	unlinking it with a compare-and-swap on its predecessor.
+ *	Traversals unlink marked elements they pass over.
+ *
+ *	Deletes are given only the element, so while an element is in
+ *	a list its prev pointer holds the list head instead of the
+ *	previous element.
+ */
+#include "SortedList.h"
+
+void LockFreeList_insert(SortedList_t *list, SortedListElement_t *element);
+int LockFreeList_delete(SortedListElement_t *element);
+SortedListElement_t *LockFreeList_lookup(SortedList_t *list, const char *key);
+int LockFreeList_length(SortedList_t *list);
+
+#endif
@@ -0,0 +1,315 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "SkipList.h"
+#include <string.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// Side table from elements to their towers, chained through the towers.
+// Sublists are locked independently, so each stripe of buckets has its
+// own lock. Zero filled, which is an unlocked default mutex
+#define TOWER_BUCKETS (1 << 16)
+#define TOWER_STRIPES 256
+
+static SkipTower_t *tower_buckets[TOWER_BUCKETS];
+static pthread_mutex_t tower_locks[TOWER_STRIPES];
+
+/**
+ * hash_address ... mix the bits of an element address
+ *	Gives the tower height and side table bucket of an element, so no
+ *	shared random state is needed
+ */
+static unsigned long long hash_address(const void *element)
+{
+	unsigned long long x = (unsigned long long) (size_t) element;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+/**
+ * random_level ... number of express lanes for an element
+ *	Each further lane is taken with probability 1/4
+ * @param SortedListElement_t *element ... element being inserted
+ * @return int number of lanes, 0 to SKIPLIST_MAX_LEVEL
+ */
+static int random_level(SortedListElement_t *element)
+{
+	unsigned long long x = hash_address(element);
+	int level = 0;
+	while ((x & 3) == 0 && level < SKIPLIST_MAX_LEVEL)
+	{
+		level++;
+		x >>= 2;
+	}
+	return level;
+}
+
+static inline int tower_bucket(const SortedListElement_t *element)
+{
+	return (hash_address(element) >> 40) & (TOWER_BUCKETS - 1);
+}
+
+/**
+ * find_tower ... tower of an element
+ * @return the tower, or NULL if the element has none
+ */
+static SkipTower_t *find_tower(const SortedListElement_t *element)
+{
+	int bucket = tower_bucket(element);
+	pthread_mutex_t *lock = &tower_locks[bucket % TOWER_STRIPES];
+
+	pthread_mutex_lock(lock);
+	SkipTower_t *tower = tower_buckets[bucket];
+	while (tower && tower->element != element)
+	{
+		tower = tower->hash_next;
+	}
+	pthread_mutex_unlock(lock);
+	return tower;
+}
+
+/**
+ * new_tower ... allocate a tower and enter it in the side table
+ */
+static SkipTower_t *new_tower(SortedListElement_t *element, int level)
+{
+	SkipTower_t *tower = (SkipTower_t *) calloc(1, sizeof(SkipTower_t) +
+												level * sizeof(struct SkipListLane));
+	if (tower == NULL)
+	{
+		abort();
+	}
+	tower->element = element;
+	tower->level = level;
+
+	int bucket = tower_bucket(element);
+	pthread_mutex_t *lock = &tower_locks[bucket % TOWER_STRIPES];
+
+	pthread_mutex_lock(lock);
+	tower->hash_next = tower_buckets[bucket];
+	tower_buckets[bucket] = tower;
+	pthread_mutex_unlock(lock);
+	return tower;
+}
+
+/**
+ * free_tower ... remove a tower from the side table and free it
+ */
+static void free_tower(SkipTower_t *tower)
+{
+	int bucket = tower_bucket(tower->element);
+	pthread_mutex_t *lock = &tower_locks[bucket % TOWER_STRIPES];
+
+	pthread_mutex_lock(lock);
+	SkipTower_t **link = &tower_buckets[bucket];
+	while (*link != tower)
+	{
+		link = &(*link)->hash_next;
+	}
+	*link = tower->hash_next;
+	pthread_mutex_unlock(lock);
+	free(tower);
+}
+
+/**
+ * find_before ... walk the express lanes towards a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the key being searched for
+ * @param SkipTower_t **preds ... if not NULL, filled with the last
+ *	  tower before the key in every lane, or NULL if the head has no
+ *	  tower yet
+ * @return last element with a tower before the key, or the list head
+ */
+static SortedListElement_t *find_before(SortedList_t *list, const char *key, SkipTower_t **preds)
+{
+	SkipTower_t *prev = find_tower(list);
+	int i;
+	for (i = SKIPLIST_MAX_LEVEL - 1; i >= 0; i--)
+	{
+		while (prev && prev->lanes[i].next && strcmp(prev->lanes[i].next->element->key, key) < 0)
+		{
+			prev = prev->lanes[i].next;
+		}
+		if (preds)
+		{
+			preds[i] = prev;
+		}
+	}
+	return prev ? prev->element : list;
+}
+
+/**
+ * SkipList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void SkipList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	SkipTower_t *preds[SKIPLIST_MAX_LEVEL];
+
+	// Find first node greater than or equal to element, insert before said node
+	SortedListElement_t *prev = find_before(list, element->key, preds);
+	SortedListElement_t *curr = prev->next;
+	while (curr)
+	{
+		if (strcmp(element->key, curr->key) <= 0)
+		{
+			break;
+		}
+		prev = curr;
+		curr = curr->next;
+	}
+
+	if (opt_yield & INSERT_YIELD)
+	{
+		sched_yield();
+	}
+
+	element->prev = prev;
+	element->next = curr;
+	prev->next = element;
+
+	// If not last element update curr, otherwise update head
+	if (curr)
+	{
+		curr->prev = element;
+	}
+
+	int level = random_level(element);
+	if (level == 0)
+	{
+		return;
+	}
+
+	// The first tower in the list gives the head one in every lane
+	int i;
+	if (preds[0] == NULL)
+	{
+		SkipTower_t *head = new_tower(list, SKIPLIST_MAX_LEVEL);
+		for (i = 0; i < SKIPLIST_MAX_LEVEL; i++)
+		{
+			preds[i] = head;
+		}
+	}
+
+	// Equal keys go in front in every lane, matching the bottom level
+	SkipTower_t *tower = new_tower(element, level);
+	for (i = 0; i < level; i++)
+	{
+		SkipTower_t *next = preds[i]->lanes[i].next;
+		tower->lanes[i].prev = preds[i];
+		tower->lanes[i].next = next;
+		preds[i]->lanes[i].next = tower;
+		if (next)
+		{
+			next->lanes[i].prev = tower;
+		}
+	}
+}
+
+/**
+ * SkipList_delete ... remove an element from a sorted list
+ * @param SortedListElement_t *element ... element to be removed
+ * @return 0: element deleted successfully, 1: corrtuped prev/next pointers
+ */
+int SkipList_delete(SortedListElement_t *element)
+{
+	if (element == NULL)
+	{
+		return 1;
+	}
+
+	SortedListElement_t *prev = element->prev;
+	SortedListElement_t *next = element->next;
+
+	if (opt_yield & DELETE_YIELD)
+	{
+		sched_yield();
+	}
+
+	if (prev == NULL && next == NULL)
+	{
+		return 0;
+	}
+	if ((prev && prev->next != element) || (next && next->prev != element))
+	{
+		return 1;
+	}
+
+	if (prev)
+	{
+		prev->next = next;
+	}
+	if (next)
+	{
+		next->prev = prev;
+	}
+
+	SkipTower_t *tower = random_level(element) ? find_tower(element) : NULL;
+	if (tower == NULL)
+	{
+		return 0;
+	}
+
+	// Every lane the tower is in has a predecessor, at worst the head
+	int i;
+	for (i = 0; i < tower->level; i++)
+	{
+		SkipTower_t *lane_prev = tower->lanes[i].prev;
+		SkipTower_t *lane_next = tower->lanes[i].next;
+		lane_prev->lanes[i].next = lane_next;
+		if (lane_next)
+		{
+			lane_next->lanes[i].prev = lane_prev;
+		}
+	}
+
+	// Every tower is in the lowest lane, so once it is empty the
+	// head's tower goes too
+	SkipTower_t *first = tower->lanes[0].prev;
+	free_tower(tower);
+	if (first->element->key == NULL && first->lanes[0].next == NULL)
+	{
+		free_tower(first);
+	}
+	return 0;
+}
+
+/**
+ * SkipList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *SkipList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	// Following is critical section because list could
+	// be updated as we are checking for key
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	SortedListElement_t *curr = find_before(list, key, NULL)->next;
+	while (curr && strcmp(curr->key, key) < 0)
+	{
+		curr = curr->next;
+	}
+
+	if (curr && strcmp(curr->key, key) == 0)
+	{
+		return curr;
+	}
+	return NULL;
+}
@@ -0,0 +1,46 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+/**
+ * SkipList (and SkipTower)
+ *
+ *	A skip list behind the SortedList interface. The bottom level
+ *	is the SortedListElement itself, a doubly linked list kept in
+ *	the same order as the linear implementation, so length checks
+ *	and deletes see the same pointers. Above it some elements get a
+ *	tower, allocated on insert, that is linked into a number of
+ *	doubly linked express lanes, with each lane holding about a
+ *	quarter of the elements of the lane below.
+ *
+ *	Elements stay plain SortedListElements. Towers are found from
+ *	their element through a side table, and the list head gets a
+ *	tower linked into every lane once the first tower is inserted,
+ *	which is freed again when the lanes empty.
+ */
+#include "SortedList.h"
+
+#define SKIPLIST_MAX_LEVEL 12
+
+struct SkipTower;
+
+struct SkipListLane {
+	struct SkipTower *prev;
+	struct SkipTower *next;
+};
+
+struct SkipTower {
+	SortedListElement_t *element;
+	struct SkipTower *hash_next;
+	int level;
+	struct SkipListLane lanes[];
+};
+typedef struct SkipTower SkipTower_t;
+
+void SkipList_insert(SortedList_t *list, SortedListElement_t *element);
+int SkipList_delete(SortedListElement_t *element);
+SortedListElement_t *SkipList_lookup(SortedList_t *list, const char *key);
+
+#endif
@@ -2,16 +2,23 @@
  */
 
 #include "SortedList.h"
+#include "SkipList.h"
+#include "LockFreeList.h"
+#include "HandOverHandList.h"
+#include "LazyList.h"
+#include "InlineKeyList.h"
+#include "UnrolledList.h"
 #include <string.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /**
- * SortedList_insert ... insert an element into a sorted list
+ * linear_insert ... insert an element into a sorted list
  * @param SortedList_t *list ... header for the list
  * @param SortedListElement_t *element ... element to be added to the list
  */
-void SortedList_insert(SortedList_t *list, SortedListElement_t *element)
+static void linear_insert(SortedList_t *list, SortedListElement_t *element)
 {
 	SortedListElement_t* prev = list;
 	SortedListElement_t* curr = prev->next;
@@ -44,11 +51,54 @@ void SortedList_insert(SortedList_t *list, SortedListElement_t *element)
 }
 
 /**
- * SortedList_delete ... remove an element from a sorted list
+ * linear_insert_batch ... merge a sorted batch into a sorted list
+ *	The batch is in key order, so each element is placed by carrying
+ *	on the walk from where the previous one went in
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t **elements ... elements sorted by key
+ * @param int n ... number of elements
+ */
+static void linear_insert_batch(SortedList_t *list, SortedListElement_t **elements, int n)
+{
+	SortedListElement_t* prev = list;
+	SortedListElement_t* curr = prev->next;
+
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		SortedListElement_t* element = elements[i];
+
+		// Find first node greater than or equal to element, insert before said node
+		while (curr && strcmp(element->key, curr->key) > 0)
+		{
+			prev = curr;
+			curr = curr->next;
+		}
+
+		if (opt_yield & INSERT_YIELD)
+		{
+			sched_yield();
+		}
+
+		element->prev = prev;
+		element->next = curr;
+		prev->next = element;
+		if (curr)
+		{
+			curr->prev = element;
+		}
+
+		// Later elements in the batch sort after this one
+		prev = element;
+	}
+}
+
+/**
+ * linear_delete ... remove an element from a sorted list
  * @param SortedListElement_t *element ... element to be removed
  * @return 0: element deleted successfully, 1: corrtuped prev/next pointers
  */
-int SortedList_delete( SortedListElement_t *element)
+static int linear_delete(SortedListElement_t *element)
 {
 	if (element == NULL)
 	{
@@ -87,12 +137,12 @@ int SortedList_delete( SortedListElement_t *element)
 }
 
 /**
- * SortedList_lookup ... search sorted list for a key
+ * linear_lookup ... search sorted list for a key
  * @param SortedList_t *list ... header for the list
  * @param const char * key ... the desired key
  * @return pointer to matching element, or NULL if none is found
  */
-SortedListElement_t *SortedList_lookup(SortedList_t *list, const char *key)
+static SortedListElement_t *linear_lookup(SortedList_t *list, const char *key)
 {
 	if (list == NULL || key == NULL)
 	{
@@ -120,12 +170,12 @@ SortedListElement_t *SortedList_lookup(SortedList_t *list, const char *key)
 }
 
 /**
- * SortedList_length ... count elements in a sorted list
+ * linear_length ... count elements in a sorted list
  * @param SortedList_t *list ... header for the list
  * @return int number of elements in list (excluding head)
  *	   -1 if the list is corrupted
  */
-int SortedList_length(SortedList_t *list)
+static int linear_length(SortedList_t *list)
 {
 	// Check for empty list
 	if (list == NULL)
@@ -166,4 +216,137 @@ int SortedList_length(SortedList_t *list)
 		count++;
 	}
 	return count;
-}
\ No newline at end of file
+}
+
+/**
+ * Operations of one list implementation
+ */
+struct SortedList_impl {
+	const char *name;
+	size_t element_size;
+	void (*insert)(SortedList_t *list, SortedListElement_t *element);
+	int (*delete)(SortedListElement_t *element);
+	SortedListElement_t *(*lookup)(SortedList_t *list, const char *key);
+	int (*length)(SortedList_t *list);
+	void (*insert_batch)(SortedList_t *list, SortedListElement_t **elements, int n);
+};
+
+static const struct SortedList_impl impls[] = {
+	{"linear", sizeof(SortedListElement_t), linear_insert, linear_delete,
+	 linear_lookup, linear_length, linear_insert_batch},
+	{"skiplist", sizeof(SortedListElement_t), SkipList_insert, SkipList_delete,
+	 SkipList_lookup, linear_length, NULL},
+	{"lockfree", sizeof(SortedListElement_t), LockFreeList_insert, LockFreeList_delete,
+	 LockFreeList_lookup, LockFreeList_length, NULL},
+	{"handoverhand", sizeof(HandOverHandNode_t), HandOverHandList_insert, HandOverHandList_delete,
+	 HandOverHandList_lookup, HandOverHandList_length, NULL},
+	{"lazy", sizeof(LazyListNode_t), LazyList_insert, LazyList_delete,
+	 LazyList_lookup, LazyList_length, NULL},
+	{"inline", sizeof(InlineKeyNode_t), InlineKeyList_insert, linear_delete,
+	 InlineKeyList_lookup, linear_length, NULL},
+	{"unrolled", sizeof(UnrolledNode_t), UnrolledList_insert, UnrolledList_delete,
+	 UnrolledList_lookup, UnrolledList_length, NULL},
+	{NULL, 0, NULL, NULL, NULL, NULL, NULL}
+};
+
+#ifdef SORTEDLIST_SKIPLIST
+#define DEFAULT_IMPL (&impls[1])
+#else
+#define DEFAULT_IMPL (&impls[0])
+#endif
+
+size_t SortedList_element_size = sizeof(SortedListElement_t);
+
+static const struct SortedList_impl *impl = DEFAULT_IMPL;
+
+/**
+ * SortedList_set_impl ... choose the list implementation
+ * @param const char * name ... name of the implementation, NULL for the default
+ * @return 0: implementation selected, -1: unknown name
+ */
+int SortedList_set_impl(const char *name)
+{
+	if (name == NULL)
+	{
+		impl = DEFAULT_IMPL;
+		SortedList_element_size = impl->element_size;
+		return 0;
+	}
+
+	const struct SortedList_impl *i;
+	for (i = impls; i->name; i++)
+	{
+		if (strcmp(i->name, name) == 0)
+		{
+			impl = i;
+			SortedList_element_size = i->element_size;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void SortedList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	impl->insert(list, element);
+}
+
+static int compare_elements(const void *a, const void *b)
+{
+	return strcmp((*(SortedListElement_t * const *) a)->key,
+				  (*(SortedListElement_t * const *) b)->key);
+}
+
+void SortedList_sort_batch(SortedListElement_t **elements, int n)
+{
+	qsort(elements, n, sizeof(SortedListElement_t *), compare_elements);
+}
+
+/**
+ * SortedList_insert_batch ... insert a sorted batch in one pass
+ *	Implementations without a merge insert the batch one element
+ *	at a time
+ */
+void SortedList_insert_batch(SortedList_t *list, SortedListElement_t **elements, int n)
+{
+	if (impl->insert_batch)
+	{
+		impl->insert_batch(list, elements, n);
+		return;
+	}
+
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		impl->insert(list, elements[i]);
+	}
+}
+
+int SortedList_delete( SortedListElement_t *element)
+{
+	return impl->delete(element);
+}
+
+SortedListElement_t *SortedList_lookup(SortedList_t *list, const char *key)
+{
+	return impl->lookup(list, key);
+}
+
+/**
+ * SortedList_remove ... look up a key and delete its element
+ *	Deletes only touch the element's neighbours, so this is one walk
+ */
+SortedListElement_t *SortedList_remove(SortedList_t *list, const char *key)
+{
+	SortedListElement_t *element = impl->lookup(list, key);
+	if (element == NULL || impl->delete(element) != 0)
+	{
+		return NULL;
+	}
+	return element;
+}
+
+int SortedList_length(SortedList_t *list)
+{
+	return impl->length(list);
+}
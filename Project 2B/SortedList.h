@@ -1,89 +1,175 @@
-/* NAME: Anirudh Veeraragavan
- */
-
-/**
- * SortedList (and SortedListElement)
- *
- *	A doubly linked list, kept sorted by a specified key.
- *	This structure is used for a list head, and each element
- *	of the list begins with this structure.
- *
- *	The list head is in the list, and an empty list contains
- *	only a list head.  The next pointer in the head points at
- *      the first (lowest valued) elment in the list.  The prev
- *      pointer in the list head points at the last (highest valued)
- *      element in the list.
- *
- *      The list head is also recognizable by its NULL key pointer.
- *
- * NOTE: This header file is an interface specification, and you
- *       are not allowed to make any changes to it.
- */
-struct SortedListElement {
-	struct SortedListElement *prev;
-	struct SortedListElement *next;
-	const char *key;
-};
-typedef struct SortedListElement SortedList_t;
-typedef struct SortedListElement SortedListElement_t;
-
-
-/**
- * SortedList_insert ... insert an element into a sorted list
- *
- *	The specified element will be inserted in to
- *	the specified list, which will be kept sorted
- *	in ascending order based on associated keys
- *
- * @param SortedList_t *list ... header for the list
- * @param SortedListElement_t *element ... element to be added to the list
- */
-void SortedList_insert(SortedList_t *list, SortedListElement_t *element);
-
-/**
- * SortedList_delete ... remove an element from a sorted list
- *
- *	The specified element will be removed from whatever
- *	list it is currently in.
- *
- *	Before doing the deletion, we check to make sure that
- *	next->prev and prev->next both point to this node
- *
- * @param SortedListElement_t *element ... element to be removed
- *
- * @return 0: element deleted successfully, 1: corrtuped prev/next pointers
- *
- */
-int SortedList_delete( SortedListElement_t *element);
-
-/**
- * SortedList_lookup ... search sorted list for a key
- *
- *	The specified list will be searched for an
- *	element with the specified key.
- *
- * @param SortedList_t *list ... header for the list
- * @param const char * key ... the desired key
- *
- * @return pointer to matching element, or NULL if none is found
- */
-SortedListElement_t *SortedList_lookup(SortedList_t *list, const char *key);
-
-/**
- * SortedList_length ... count elements in a sorted list
- *	While enumeratign list, it checks all prev/next pointers
- *
- * @param SortedList_t *list ... header for the list
- *
- * @return int number of elements in list (excluding head)
- *	   -1 if the list is corrupted
- */
-int SortedList_length(SortedList_t *list);
-
-/**
- * variable to enable diagnositc yield calls
- */
-extern int opt_yield;
-#define	INSERT_YIELD	0x01	// yield in insert critical section
-#define	DELETE_YIELD	0x02	// yield in delete critical section
-#define	LOOKUP_YIELD	0x04	// yield in lookup/length critical esction
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef SORTEDLIST_H
+#define SORTEDLIST_H
+
+/**
+ * SortedList (and SortedListElement)
+ *
+ *	A doubly linked list, kept sorted by a specified key.
+ *	This structure is used for a list head, and each element
+ *	of the list begins with this structure.
+ *
+ *	The list head is in the list, and an empty list contains
+ *	only a list head.  The next pointer in the head points at
+ *      the first (lowest valued) elment in the list.  The prev
+ *      pointer in the list head points at the last (highest valued)
+ *      element in the list.
+ *
+ *      The list head is also recognizable by its NULL key pointer.
+ *
+ * NOTE: This header file is an interface specification, and you
+ *       are not allowed to make any changes to it.
+ */
+#include <stddef.h>
+
+struct SortedListElement {
+	struct SortedListElement *prev;
+	struct SortedListElement *next;
+	const char *key;
+};
+typedef struct SortedListElement SortedList_t;
+typedef struct SortedListElement SortedListElement_t;
+
+
+/**
+ * SortedList_insert ... insert an element into a sorted list
+ *
+ *	The specified element will be inserted in to
+ *	the specified list, which will be kept sorted
+ *	in ascending order based on associated keys
+ *
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void SortedList_insert(SortedList_t *list, SortedListElement_t *element);
+
+/**
+ * SortedList_sort_batch ... sort a batch of elements by key
+ *
+ *	Prepares a batch for SortedList_insert_batch. Needs no lock,
+ *	so callers sort before taking the lock over the list.
+ *
+ * @param SortedListElement_t **elements ... elements to be sorted
+ * @param int n ... number of elements
+ */
+void SortedList_sort_batch(SortedListElement_t **elements, int n);
+
+/**
+ * SortedList_insert_batch ... insert several elements into a sorted list
+ *
+ *	The batch, which must already be in ascending key order, is
+ *	merged into the list in a single walk, so a caller holding a
+ *	lock over the list takes it once for the whole batch rather
+ *	than once per element.
+ *
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t **elements ... elements to be added, sorted
+ *	  by SortedList_sort_batch
+ * @param int n ... number of elements
+ */
+void SortedList_insert_batch(SortedList_t *list, SortedListElement_t **elements, int n);
+
+/**
+ * SortedList_delete ... remove an element from a sorted list
+ *
+ *	The specified element will be removed from whatever
+ *	list it is currently in.
+ *
+ *	Before doing the deletion, we check to make sure that
+ *	next->prev and prev->next both point to this node
+ *
+ * @param SortedListElement_t *element ... element to be removed
+ *
+ * @return 0: element deleted successfully, 1: corrtuped prev/next pointers
+ *
+ */
+int SortedList_delete( SortedListElement_t *element);
+
+/**
+ * SortedList_lookup ... search sorted list for a key
+ *
+ *	The specified list will be searched for an
+ *	element with the specified key.
+ *
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ *
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *SortedList_lookup(SortedList_t *list, const char *key);
+
+/**
+ * SortedList_remove ... find and remove the element with a key
+ *
+ *	Does the work of SortedList_lookup followed by SortedList_delete,
+ *	so a caller holding a lock over the list takes it once instead
+ *	of once for each.
+ *
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... key of the element to remove
+ *
+ * @return pointer to the removed element, or NULL if none was found
+ *	   or its prev/next pointers were corrupted
+ */
+SortedListElement_t *SortedList_remove(SortedList_t *list, const char *key);
+
+/**
+ * SortedList_length ... count elements in a sorted list
+ *	While enumeratign list, it checks all prev/next pointers
+ *
+ * @param SortedList_t *list ... header for the list
+ *
+ * @return int number of elements in list (excluding head)
+ *	   -1 if the list is corrupted
+ */
+int SortedList_length(SortedList_t *list);
+
+/**
+ * SortedList_set_impl ... choose the list implementation
+ *
+ *	"linear" is the doubly linked list scanned from the head.
+ *	"skiplist" keeps the same doubly linked bottom level but
+ *	adds express lanes above it for O(log n) operations.
+ *	"lockfree" is a Harris/Michael list that needs no lock.
+ *	"handoverhand" locks each element and couples the locks
+ *	while walking the list.
+ *	"lazy" reads without locks and locks only the two nodes
+ *	around an insert or delete.
+ *	"inline" is the linear list with the start of each key copied
+ *	into its element, so most compares stay on that cache line.
+ *	"unrolled" keeps the elements in chunks of sorted key arrays,
+ *	binary searched once the right chunk is found.
+ *	The default is linear unless built with -DSORTEDLIST_SKIPLIST.
+ *
+ *	Must be called before any element or list head is allocated.
+ *
+ * @param const char * name ... name of the implementation, NULL
+ *	  for the default
+ *
+ * @return 0: implementation selected, -1: unknown name
+ */
+int SortedList_set_impl(const char *name);
+
+/**
+ * SortedList_element_size ... bytes to allocate per element
+ *
+ *	linear, skiplist and lockfree use plain SortedListElements, so
+ *	callers that allocate sizeof(SortedListElement_t) keep working
+ *	with them, including the default under -DSORTEDLIST_SKIPLIST.
+ *	handoverhand, lazy, inline and unrolled keep extra state after
+ *	the SortedListElement fields, so with those every element and
+ *	list head must be allocated with this size and zero filled.
+ */
+extern size_t SortedList_element_size;
+
+/**
+ * variable to enable diagnositc yield calls
+ */
+extern int opt_yield;
+#define	INSERT_YIELD	0x01	// yield in insert critical section
+#define	DELETE_YIELD	0x02	// yield in delete critical section
+#define	LOOKUP_YIELD	0x04	// yield in lookup/length critical esction
+
+#endif
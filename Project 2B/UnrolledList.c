@@ -0,0 +1,331 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#include "UnrolledList.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+static inline UnrolledNode_t *node(SortedListElement_t *element)
+{
+	return (UnrolledNode_t *) element;
+}
+
+/**
+ * key_prefix ... first 8 bytes of a key as a big-endian integer
+ *	Bytes past the end of the key are zero, so prefixes order like strcmp
+ */
+static uint64_t key_prefix(const char *key)
+{
+	uint64_t prefix = 0;
+	int i;
+	for (i = 0; i < 8; i++)
+	{
+		prefix <<= 8;
+		if (key[i] == 0)
+		{
+			// Shift the rest in at once, never by the full 64 bits
+			return prefix << (8 * (7 - i));
+		}
+		prefix |= (unsigned char) key[i];
+	}
+	return prefix;
+}
+
+/**
+ * compare ... order a key against slot i of a chunk
+ * @return <0, 0 or >0 as strcmp(key, key of slot i) would
+ */
+static inline int compare(uint64_t prefix, const char *key, UnrolledChunk_t *chunk, int i)
+{
+	if (prefix != chunk->prefixes[i])
+	{
+		return prefix < chunk->prefixes[i] ? -1 : 1;
+	}
+	return strcmp(key, chunk->elements[i]->key);
+}
+
+/**
+ * find_chunk ... chunk that a key belongs in
+ * @return last chunk whose first key is not above the key, the first
+ *	   chunk if there is none, or NULL for an empty list
+ */
+static UnrolledChunk_t *find_chunk(SortedList_t *list, uint64_t prefix, const char *key)
+{
+	UnrolledChunk_t *chunk = node(list)->chunk;
+	while (chunk && chunk->next && compare(prefix, key, chunk->next, 0) >= 0)
+	{
+		chunk = chunk->next;
+	}
+	return chunk;
+}
+
+/**
+ * lower_bound ... binary search a chunk
+ * @return first slot whose key is not below the key, count if none
+ */
+static int lower_bound(UnrolledChunk_t *chunk, uint64_t prefix, const char *key)
+{
+	int lo = 0;
+	int hi = chunk->count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (compare(prefix, key, chunk, mid) > 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * move_slots ... move slots from one chunk to another
+ *	Slots may overlap when both chunks are the same, and moved
+ *	elements are pointed at their new chunk
+ */
+static void move_slots(UnrolledChunk_t *to, int to_slot, UnrolledChunk_t *from, int from_slot, int n)
+{
+	memmove(&to->prefixes[to_slot], &from->prefixes[from_slot], n * sizeof(uint64_t));
+	memmove(&to->elements[to_slot], &from->elements[from_slot], n * sizeof(SortedListElement_t *));
+	if (to != from)
+	{
+		int i;
+		for (i = to_slot; i < to_slot + n; i++)
+		{
+			node(to->elements[i])->chunk = to;
+		}
+	}
+}
+
+/**
+ * new_chunk ... allocate an empty chunk and link it after another
+ * @param UnrolledNode_t *list ... head of the list
+ * @param UnrolledChunk_t *prev ... chunk to follow, NULL for the front
+ */
+static UnrolledChunk_t *new_chunk(UnrolledNode_t *list, UnrolledChunk_t *prev)
+{
+	UnrolledChunk_t *chunk = (UnrolledChunk_t *) calloc(1, sizeof(UnrolledChunk_t));
+	if (chunk == NULL)
+	{
+		abort();
+	}
+
+	chunk->list = list;
+	chunk->prev = prev;
+	chunk->next = prev ? prev->next : list->chunk;
+	if (chunk->next)
+	{
+		chunk->next->prev = chunk;
+	}
+	if (prev)
+	{
+		prev->next = chunk;
+	}
+	else
+	{
+		list->chunk = chunk;
+	}
+	return chunk;
+}
+
+/**
+ * free_chunk ... unlink and free a chunk
+ */
+static void free_chunk(UnrolledChunk_t *chunk)
+{
+	if (chunk->prev)
+	{
+		chunk->prev->next = chunk->next;
+	}
+	else
+	{
+		chunk->list->chunk = chunk->next;
+	}
+	if (chunk->next)
+	{
+		chunk->next->prev = chunk->prev;
+	}
+	free(chunk);
+}
+
+/**
+ * UnrolledList_insert ... insert an element into a sorted list
+ * @param SortedList_t *list ... header for the list
+ * @param SortedListElement_t *element ... element to be added to the list
+ */
+void UnrolledList_insert(SortedList_t *list, SortedListElement_t *element)
+{
+	uint64_t prefix = key_prefix(element->key);
+	UnrolledChunk_t *chunk = find_chunk(list, prefix, element->key);
+	if (chunk == NULL)
+	{
+		chunk = new_chunk(node(list), NULL);
+	}
+	int slot = lower_bound(chunk, prefix, element->key);
+
+	if (opt_yield & INSERT_YIELD)
+	{
+		sched_yield();
+	}
+
+	// Split a full chunk, moving its upper half into a new one
+	if (chunk->count == UNROLLED_CAPACITY)
+	{
+		UnrolledChunk_t *upper = new_chunk(node(list), chunk);
+		int half = UNROLLED_CAPACITY / 2;
+		move_slots(upper, 0, chunk, half, UNROLLED_CAPACITY - half);
+		upper->count = UNROLLED_CAPACITY - half;
+		chunk->count = half;
+		if (slot > half)
+		{
+			chunk = upper;
+			slot -= half;
+		}
+	}
+
+	move_slots(chunk, slot + 1, chunk, slot, chunk->count - slot);
+	chunk->prefixes[slot] = prefix;
+	chunk->elements[slot] = element;
+	chunk->count++;
+	node(element)->chunk = chunk;
+}
+
+/**
+ * UnrolledList_delete ... remove an element from a sorted list
+ * @param SortedListElement_t *element ... element to be removed
+ * @return 0: element deleted successfully, 1: element is not in its chunk
+ */
+int UnrolledList_delete(SortedListElement_t *element)
+{
+	if (element == NULL)
+	{
+		return 1;
+	}
+
+	UnrolledChunk_t *chunk = node(element)->chunk;
+	if (chunk == NULL)
+	{
+		return 1;
+	}
+
+	if (opt_yield & DELETE_YIELD)
+	{
+		sched_yield();
+	}
+
+	int slot;
+	for (slot = 0; slot < chunk->count && chunk->elements[slot] != element; slot++);
+	if (slot == chunk->count)
+	{
+		return 1;
+	}
+
+	move_slots(chunk, slot, chunk, slot + 1, chunk->count - slot - 1);
+	chunk->count--;
+	node(element)->chunk = NULL;
+
+	// Free an empty chunk, fold a sparse one into its successor's room
+	UnrolledChunk_t *next = chunk->next;
+	if (chunk->count == 0)
+	{
+		free_chunk(chunk);
+	}
+	else if (chunk->count < UNROLLED_CAPACITY / 4 && next &&
+			 chunk->count + next->count <= UNROLLED_CAPACITY * 3 / 4)
+	{
+		move_slots(chunk, chunk->count, next, 0, next->count);
+		chunk->count += next->count;
+		free_chunk(next);
+	}
+	return 0;
+}
+
+/**
+ * UnrolledList_lookup ... search sorted list for a key
+ * @param SortedList_t *list ... header for the list
+ * @param const char * key ... the desired key
+ * @return pointer to matching element, or NULL if none is found
+ */
+SortedListElement_t *UnrolledList_lookup(SortedList_t *list, const char *key)
+{
+	if (list == NULL || key == NULL)
+	{
+		return NULL;
+	}
+
+	// Following is critical section because list could
+	// be updated as we are checking for key
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	uint64_t prefix = key_prefix(key);
+	UnrolledChunk_t *chunk = find_chunk(list, prefix, key);
+	if (chunk == NULL)
+	{
+		return NULL;
+	}
+
+	int slot = lower_bound(chunk, prefix, key);
+	if (slot < chunk->count && compare(prefix, key, chunk, slot) == 0)
+	{
+		return chunk->elements[slot];
+	}
+	return NULL;
+}
+
+/**
+ * UnrolledList_length ... count elements in a sorted list
+ *	While enumerating, checks chunk links, back pointers and key order
+ * @param SortedList_t *list ... header for the list
+ * @return int number of elements in list (excluding head)
+ *	   -1 if the list is corrupted
+ */
+int UnrolledList_length(SortedList_t *list)
+{
+	if (list == NULL)
+	{
+		return 0;
+	}
+
+	// Following is critical section because list could
+	// be updated as we are checking its length
+	if (opt_yield & LOOKUP_YIELD)
+	{
+		sched_yield();
+	}
+
+	int count = 0;
+	const char *last = NULL;
+	UnrolledChunk_t *prev = NULL;
+	UnrolledChunk_t *chunk = node(list)->chunk;
+	while (chunk)
+	{
+		if (chunk->prev != prev || chunk->count <= 0 || chunk->count > UNROLLED_CAPACITY)
+		{
+			return -1;
+		}
+
+		int i;
+		for (i = 0; i < chunk->count; i++)
+		{
+			SortedListElement_t *element = chunk->elements[i];
+			if (node(element)->chunk != chunk || (last && strcmp(last, element->key) > 0))
+			{
+				return -1;
+			}
+			last = element->key;
+		}
+
+		count += chunk->count;
+		prev = chunk;
+		chunk = chunk->next;
+	}
+	return count;
+}
@@ -0,0 +1,52 @@
+/* NAME: Anirudh Veeraragavan
+ */
+
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+
+/**
+ * UnrolledList (and UnrolledNode, UnrolledChunk)
+ *
+ *	An unrolled sorted list behind the SortedList interface. The
+ *	elements are kept, in key order, in a singly walked list of
+ *	chunks of up to UNROLLED_CAPACITY element pointers, each next to
+ *	a big-endian 8 byte prefix of its key. A search steps from chunk
+ *	to chunk on the first prefix only, then binary searches the one
+ *	chunk, so it follows one pointer per chunk rather than one per
+ *	element and only reads a key on a prefix tie.
+ *
+ *	A full chunk is split in half on insert, and a chunk that drops
+ *	below a quarter full is merged with its successor when both fit
+ *	in three quarters of a chunk. Empty chunks are freed.
+ *
+ *	Every element, and the list head, is an UnrolledNode pointing at
+ *	the chunk that holds it (the head at its first chunk). The prev
+ *	and next fields of the elements are not used.
+ */
+#include "SortedList.h"
+#include <stdint.h>
+
+#define UNROLLED_CAPACITY 16
+
+struct UnrolledChunk {
+	struct UnrolledChunk *prev;
+	struct UnrolledChunk *next;
+	struct UnrolledNode *list;
+	int count;
+	uint64_t prefixes[UNROLLED_CAPACITY];
+	SortedListElement_t *elements[UNROLLED_CAPACITY];
+};
+typedef struct UnrolledChunk UnrolledChunk_t;
+
+struct UnrolledNode {
+	SortedListElement_t element;
+	struct UnrolledChunk *chunk;
+};
+typedef struct UnrolledNode UnrolledNode_t;
+
+void UnrolledList_insert(SortedList_t *list, SortedListElement_t *element);
+int UnrolledList_delete(SortedListElement_t *element);
+SortedListElement_t *UnrolledList_lookup(SortedList_t *list, const char *key);
+int UnrolledList_length(SortedList_t *list);
+
+#endif
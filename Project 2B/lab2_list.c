@@ -1,36 +1,222 @@
 /* NAME: Anirudh Veeraragavan
  */
 
+#define _GNU_SOURCE
 #include "SortedList.h"
 #include <getopt.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 #include <pthread.h>
 #include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <math.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
 
 // Global Constants
 long SUCCESS_CODE = 0;
 long ERR_CODE = 1;
 long FAIL_CODE = 2;
 
+// List operation types, also used as flat combining requests
+#define OP_INSERT 1
+#define OP_LOOKUP 2
+#define OP_DELETE 3
+#define NUM_OPS 3
+#define OP_REMOVE 4
+
+// Latency histogram: log-linear buckets, 2^HIST_SUB_BITS per power of two
+#define HIST_SUB_BITS 5
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB_COUNT)
+
+struct latency_hist {
+	long long count;
+	long long buckets[HIST_BUCKETS];
+};
+
+// Length of the random keys, excluding the terminating NUL
+#define KEY_LEN 20
+
+// Highest NUMA node number we look for in sysfs
+#define MAX_NODES 64
+
+// Most values a --sweep list may hold
+#define MAX_SWEEP 64
+
+// Hardware counters sampled with --perf, in CSV column order
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_LLC_MISSES 2
+#define PERF_TRANSFERS 3
+#define NUM_PERF 4
+
+// Counter values summed over threads, -1 when not available
+struct perf_counts {
+	long long value[NUM_PERF];
+};
+
+struct cpu_place {
+	int cpu;
+	int package;
+	int core;
+	int sibling;
+};
+
+// Measurements from one run of the test
+struct run_result {
+	long long operations;
+	long long run_time;
+	long long lock_wait;
+	double skew;
+	long long setup_time;
+	struct perf_counts perf;
+};
+
+// One thread's share of the key generation
+struct setup_args {
+	int thread_id;
+	long long per_thread;
+	size_t block_size;
+	SortedListElement_t** list_elements;
+};
+
 struct thread_args {
 	int thread_id;
 	int iterations;
 	long long num_elements;
 	long long my_wait;
+	long long rounds;
+	long long extra_lookups;
+	struct latency_hist* hist;
+	struct perf_counts perf;
 	SortedListElement_t** l_elements;
 };
 
+// Ticket lock: waiters are served in the order they took a ticket
+struct ticket_lock {
+	unsigned int next_ticket;
+	unsigned int now_serving;
+};
+
+// MCS lock: each waiter spins on a flag in its own queue node
+struct mcs_node {
+	struct mcs_node* next;
+	int locked;
+} __attribute__((aligned(64)));
+
+struct mcs_lock {
+	struct mcs_node* tail;
+};
+
+// CLH lock: each waiter spins on the node of its predecessor
+struct clh_node {
+	int locked;
+} __attribute__((aligned(64)));
+
+struct clh_lock {
+	struct clh_node* tail;
+};
+
+// Big-reader lock: a reader only touches the counter of its own CPU's
+// slot, and a writer waits for every slot to drain
+#define BR_SLOTS 64
+
+struct br_slot {
+	int readers;
+} __attribute__((aligned(64)));
+
+struct br_lock {
+	int writer;
+	struct br_slot slots[BR_SLOTS];
+};
+
+// Everything that belongs to one sublist, kept in one allocation so that
+// --numa=local can place it on the node of the threads that use it
+// The list head follows the struct, since its size depends on --impl.
+// The big-reader lock is large, so it is only allocated for --rwlock=br
+struct sublist {
+	pthread_mutex_t mutex;
+	int lock;
+	struct ticket_lock ticket;
+	struct mcs_lock mcs;
+	struct clh_lock clh;
+	pthread_rwlock_t rwlock;
+	struct br_lock* br;
+	long long size;
+};
+
+// Flat combining: each thread publishes its pending list operation in its
+// own slot and whoever holds the sublist's combiner lock runs the batch
+struct fc_slot {
+	int op;
+	int err;
+	SortedListElement_t* element;
+	const char* key;
+	SortedListElement_t* result;
+} __attribute__((aligned(64)));
+
+// Count of a thread's list phases, odd while it is inside one. Lets a
+// thread wait out stale pointers before it reuses its deleted elements
+struct phase_slot {
+	int count;
+} __attribute__((aligned(64)));
+
 // Global Variables
 int opt_yield;
 SortedList_t** head;
+struct sublist** lists;
 char* sync_method = NULL;
-pthread_mutex_t* mutex = NULL;
-int* lock = NULL;
+char* list_impl = NULL;
+struct clh_node* clh_nodes = NULL;
+struct br_lock* br_locks = NULL;
+struct fc_slot* fc_slots = NULL;
+struct phase_slot* phase_slots = NULL;
+long long* size_counts = NULL;
+int size_stride = 0;
+int opt_validate = 0;
+int batch_size = 1;
+int opt_remove = 0;
+int num_threads = 1;
 int num_lists = 1;
+int opt_latency = 0;
+int backoff_cap = 1024;
+int spin_limit = 100;
+int opt_big_reader = 0;
+double lookups_per_element = 0;
+char* affinity = NULL;
+char* numa_policy = NULL;
+int* thread_cpu = NULL;
+pthread_barrier_t start_barrier;
+double duration = 0;
+int stop_flag = 0;
+int opt_sweep = 0;
+int sweep_reps = 5;
+int sweep_warmup = 1;
+int opt_perf = 0;
+unsigned long long perf_raw_transfers = 0;
+char* element_arena = NULL;
+void** numa_blocks = NULL;
+size_t numa_block_size = 0;
+unsigned long long seed = 1;
+
+// Per thread queue state for the MCS and CLH locks
+__thread struct mcs_node mcs_me;
+__thread struct clh_node* clh_me;
+__thread struct clh_node* clh_pred;
+
+// Slot of the big-reader lock this thread read-locked last
+__thread int br_my_slot;
 
 // INPUT: Name of sys call that threw error
 // Prints reason for error and terminates program
@@ -43,6 +229,694 @@ void process_failed_sys_call(const char syscall[])
 	exit(ERR_CODE);
 }
 
+// INPUT: Number of bytes to allocate
+// Return zero filled memory starting on a cache line, for arrays of
+// structs that are padded to cache lines so they never share one
+void* alloc_cache_aligned(size_t size)
+{
+	void* mem;
+	if (posix_memalign(&mem, 64, size) != 0)
+	{
+		process_failed_sys_call("posix_memalign");
+	}
+	memset(mem, 0, size);
+	return mem;
+}
+
+// INPUT: Start and end of an interval
+// Return the elapsed time in nanoseconds
+long long get_time_dif(struct timespec starting, struct timespec ending)
+{
+	return (ending.tv_sec - starting.tv_sec) * 1000000000LL +
+		   (ending.tv_nsec - starting.tv_nsec);
+}
+
+// Map a latency to its bucket, exact below HIST_SUB_COUNT ns and
+// within 1 / HIST_SUB_COUNT relative error above
+int hist_index(long long value)
+{
+	if (value < HIST_SUB_COUNT)
+		return value < 0 ? 0 : value;
+
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - HIST_SUB_BITS;
+	return ((shift + 1) << HIST_SUB_BITS) + (int)((value >> shift) - HIST_SUB_COUNT);
+}
+
+// Return the midpoint of the values that map to a bucket
+long long hist_value(int index)
+{
+	if (index < HIST_SUB_COUNT)
+		return index;
+
+	int shift = (index >> HIST_SUB_BITS) - 1;
+	long long sub = (index & (HIST_SUB_COUNT - 1)) + HIST_SUB_COUNT;
+	return (sub << shift) + ((1LL << shift) >> 1);
+}
+
+void hist_merge(struct latency_hist* into, struct latency_hist* from)
+{
+	int i;
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		into->buckets[i] += from->buckets[i];
+	}
+	into->count += from->count;
+}
+
+// INPUT: Histogram and a fraction between 0 and 1
+// Return the latency below which that fraction of samples fall
+long long hist_percentile(struct latency_hist* hist, double fraction)
+{
+	long long target = (long long)(fraction * hist->count + 0.5);
+	if (target < 1)
+		target = 1;
+
+	long long seen = 0;
+	int i;
+	for (i = 0; i < HIST_BUCKETS; i++)
+	{
+		seen += hist->buckets[i];
+		if (seen >= target)
+			return hist_value(i);
+	}
+	return 0;
+}
+
+// INPUT: Thread arguments, operation type, when the operation started
+// With --latency, record the operation's latency in the thread's histogram
+void record_latency(struct thread_args* my_args, int op, struct timespec op_start)
+{
+	if (!opt_latency)
+		return;
+
+	struct timespec op_end;
+	if (clock_gettime(CLOCK_MONOTONIC, &op_end) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	struct latency_hist* hist = &my_args->hist[op - 1];
+	hist->buckets[hist_index(get_time_dif(op_start, op_end))]++;
+	hist->count++;
+}
+
+// With --latency, note when an operation started
+void start_latency(struct timespec* op_start)
+{
+	if (opt_latency && clock_gettime(CLOCK_MONOTONIC, op_start) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+}
+
+// INPUT: CPU number, name of a sysfs topology attribute
+// Return the attribute's value, or -1 if it is not available
+int read_cpu_topology(int cpu, const char* attr)
+{
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, attr);
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+		return -1;
+
+	int value = -1;
+	if (fscanf(file, "%d", &value) != 1)
+		value = -1;
+	fclose(file);
+	return value;
+}
+
+// Return the NUMA node a CPU belongs to, 0 if unknown
+int cpu_node(int cpu)
+{
+	char path[128];
+	int node;
+	for (node = 0; node < MAX_NODES; node++)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+		if (access(path, F_OK) == 0)
+			return node;
+	}
+	return 0;
+}
+
+// Compact: fill the hardware threads of a core, then cores, then packages
+int compare_compact(const void* a, const void* b)
+{
+	const struct cpu_place* x = (const struct cpu_place *) a;
+	const struct cpu_place* y = (const struct cpu_place *) b;
+	if (x->package != y->package)
+		return x->package - y->package;
+	if (x->core != y->core)
+		return x->core - y->core;
+	if (x->sibling != y->sibling)
+		return x->sibling - y->sibling;
+	return x->cpu - y->cpu;
+}
+
+// Scatter: round-robin across packages, then cores, then hardware threads
+int compare_scatter(const void* a, const void* b)
+{
+	const struct cpu_place* x = (const struct cpu_place *) a;
+	const struct cpu_place* y = (const struct cpu_place *) b;
+	if (x->sibling != y->sibling)
+		return x->sibling - y->sibling;
+	if (x->core != y->core)
+		return x->core - y->core;
+	if (x->package != y->package)
+		return x->package - y->package;
+	return x->cpu - y->cpu;
+}
+
+// INPUT: compact, scatter or a CPU list such as 0,2,4-7, and thread count
+// Return the CPU each thread is pinned to, wrapping when threads > CPUs
+int* plan_affinity(const char* spec, int threads)
+{
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+	{
+		process_failed_sys_call("sched_getaffinity");
+	}
+
+	struct cpu_place* places = (struct cpu_place *) malloc(sizeof(struct cpu_place) * CPU_SETSIZE);
+	int* plan = (int *) malloc(sizeof(int) * threads);
+	if (places == NULL || plan == NULL)
+	{
+		process_failed_sys_call("malloc");
+	}
+
+	int num_cpus = 0;
+	int cpu;
+	if (strcmp(spec, "compact") == 0 || strcmp(spec, "scatter") == 0)
+	{
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (!CPU_ISSET(cpu, &allowed))
+				continue;
+
+			places[num_cpus].cpu = cpu;
+			places[num_cpus].package = read_cpu_topology(cpu, "physical_package_id");
+			places[num_cpus].core = read_cpu_topology(cpu, "core_id");
+
+			// Number this CPU among the hardware threads of its core
+			places[num_cpus].sibling = 0;
+			int k;
+			for (k = 0; k < num_cpus; k++)
+			{
+				if (places[k].package == places[num_cpus].package &&
+					places[k].core == places[num_cpus].core)
+					places[num_cpus].sibling++;
+			}
+			num_cpus++;
+		}
+
+		qsort(places, num_cpus, sizeof(struct cpu_place),
+			  *spec == 'c' ? compare_compact : compare_scatter);
+	}
+	else
+	{
+		const char* p = spec;
+		while (*p)
+		{
+			char* end;
+			int first = strtol(p, &end, 10);
+			int last = first;
+			if (end == p)
+				break;
+			if (*end == '-')
+			{
+				p = end + 1;
+				last = strtol(p, &end, 10);
+				if (end == p)
+					break;
+			}
+			for (cpu = first; cpu <= last && num_cpus < CPU_SETSIZE; cpu++)
+			{
+				if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))
+				{
+					fprintf(stderr, "ERROR: CPU %d is not available to this process.\n", cpu);
+					exit(ERR_CODE);
+				}
+				places[num_cpus++].cpu = cpu;
+			}
+			p = end;
+			if (*p == ',')
+				p++;
+			else
+				break;
+		}
+
+		if (*p || num_cpus == 0)
+		{
+			fprintf(stderr, "ERROR: Invalid affinity '%s'.\n", spec);
+			fprintf(stderr, "%s\n", "Use compact, scatter or a CPU list such as 0,2,4-7.");
+			exit(ERR_CODE);
+		}
+	}
+
+	int i;
+	for (i = 0; i < threads; i++)
+	{
+		plan[i] = places[i % num_cpus].cpu;
+	}
+	free(places);
+	return plan;
+}
+
+// Spread all further allocations of this process across every NUMA node
+void interleave_memory()
+{
+	unsigned long mask = 0;
+	char path[64];
+	int node;
+	for (node = 0; node < MAX_NODES; node++)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+		if (access(path, F_OK) == 0)
+			mask |= 1UL << node;
+	}
+
+	if (syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8) == -1)
+	{
+		process_failed_sys_call("set_mempolicy");
+	}
+}
+
+// INPUT: Number of bytes, NUMA node to place them on
+// Return zeroed, page aligned memory; release it with munmap
+void* alloc_on_node(size_t size, int node)
+{
+	void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+	{
+		process_failed_sys_call("mmap");
+	}
+
+	unsigned long mask = 1UL << node;
+	if (syscall(SYS_mbind, mem, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) == -1)
+	{
+		process_failed_sys_call("mbind");
+	}
+	return mem;
+}
+
+// Hint to the CPU that we are in a spin-wait loop
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// INPUT: Spins so far in the current wait
+// Relax for spin_limit spins, then yield so that a preempted lock holder
+// or queue successor can run when there are more threads than CPUs
+static inline void spin_pause(int* spins)
+{
+	if (++*spins < spin_limit)
+	{
+		cpu_relax();
+		return;
+	}
+	*spins = 0;
+	sched_yield();
+}
+
+// Test-and-test-and-set: spin on a plain read and only attempt the
+// atomic once the lock looks free, backing off exponentially on failure
+void ttas_acquire(int* l)
+{
+	int delay = 1;
+	while (1)
+	{
+		while (__atomic_load_n(l, __ATOMIC_RELAXED))
+			cpu_relax();
+
+		if (!__sync_lock_test_and_set(l, 1))
+			return;
+
+		int i;
+		for (i = 0; i < delay; i++)
+			cpu_relax();
+		if (delay < backoff_cap)
+			delay <<= 1;
+	}
+}
+
+// Spin-then-park lock: 0 = free, 1 = held, 2 = held with sleepers
+// Spins for up to spin_limit tries before sleeping in the kernel
+void futex_acquire(int* l)
+{
+	int c = 0;
+	if (__atomic_compare_exchange_n(l, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	int i;
+	for (i = 0; i < spin_limit; i++)
+	{
+		c = 0;
+		if (__atomic_load_n(l, __ATOMIC_RELAXED) == 0 &&
+			__atomic_compare_exchange_n(l, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+		cpu_relax();
+	}
+
+	// Mark the lock contended so the holder knows to wake us
+	c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+	while (c != 0)
+	{
+		syscall(SYS_futex, l, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+		c = __atomic_exchange_n(l, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+void futex_release(int* l)
+{
+	if (__atomic_exchange_n(l, 0, __ATOMIC_RELEASE) == 2)
+		syscall(SYS_futex, l, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void ticket_acquire(struct ticket_lock* l)
+{
+	unsigned int my_ticket = __atomic_fetch_add(&l->next_ticket, 1, __ATOMIC_RELAXED);
+	int spins = 0;
+	while (__atomic_load_n(&l->now_serving, __ATOMIC_ACQUIRE) != my_ticket)
+		spin_pause(&spins);
+}
+
+void ticket_release(struct ticket_lock* l)
+{
+	// Only the holder writes now_serving, so a plain increment is safe
+	__atomic_store_n(&l->now_serving, l->now_serving + 1, __ATOMIC_RELEASE);
+}
+
+void mcs_acquire(struct mcs_lock* l, struct mcs_node* me)
+{
+	me->next = NULL;
+	me->locked = 1;
+
+	struct mcs_node* pred = __atomic_exchange_n(&l->tail, me, __ATOMIC_ACQ_REL);
+	if (pred == NULL)
+		return;
+
+	__atomic_store_n(&pred->next, me, __ATOMIC_RELEASE);
+	int spins = 0;
+	while (__atomic_load_n(&me->locked, __ATOMIC_ACQUIRE))
+		spin_pause(&spins);
+}
+
+void mcs_release(struct mcs_lock* l, struct mcs_node* me)
+{
+	struct mcs_node* succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE);
+	if (succ == NULL)
+	{
+		// No known successor, try to swing the tail back to empty
+		struct mcs_node* expected = me;
+		if (__atomic_compare_exchange_n(&l->tail, &expected, NULL, 0,
+										__ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return;
+
+		// A successor is enqueueing itself, wait for it to link in
+		int spins = 0;
+		while ((succ = __atomic_load_n(&me->next, __ATOMIC_ACQUIRE)) == NULL)
+			spin_pause(&spins);
+	}
+	__atomic_store_n(&succ->locked, 0, __ATOMIC_RELEASE);
+}
+
+// Returns the predecessor's node, which the caller reuses next time
+struct clh_node* clh_acquire(struct clh_lock* l, struct clh_node* me)
+{
+	__atomic_store_n(&me->locked, 1, __ATOMIC_RELAXED);
+	struct clh_node* pred = __atomic_exchange_n(&l->tail, me, __ATOMIC_ACQ_REL);
+	int spins = 0;
+	while (__atomic_load_n(&pred->locked, __ATOMIC_ACQUIRE))
+		spin_pause(&spins);
+	return pred;
+}
+
+void clh_release(struct clh_node* me)
+{
+	__atomic_store_n(&me->locked, 0, __ATOMIC_RELEASE);
+}
+
+void br_read_acquire(struct br_lock* l)
+{
+	int cpu = sched_getcpu();
+	br_my_slot = (cpu < 0 ? 0 : cpu) % BR_SLOTS;
+	int* readers = &l->slots[br_my_slot].readers;
+	while (1)
+	{
+		// Announce ourselves, then back off if a writer got in first
+		__atomic_fetch_add(readers, 1, __ATOMIC_SEQ_CST);
+		if (!__atomic_load_n(&l->writer, __ATOMIC_SEQ_CST))
+			return;
+
+		__atomic_fetch_sub(readers, 1, __ATOMIC_RELEASE);
+		while (__atomic_load_n(&l->writer, __ATOMIC_RELAXED))
+			cpu_relax();
+	}
+}
+
+void br_read_release(struct br_lock* l)
+{
+	__atomic_fetch_sub(&l->slots[br_my_slot].readers, 1, __ATOMIC_RELEASE);
+}
+
+void br_write_acquire(struct br_lock* l)
+{
+	ttas_acquire(&l->writer);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	int i;
+	for (i = 0; i < BR_SLOTS; i++)
+	{
+		while (__atomic_load_n(&l->slots[i].readers, __ATOMIC_ACQUIRE))
+			cpu_relax();
+	}
+}
+
+void br_write_release(struct br_lock* l)
+{
+	__sync_lock_release(&l->writer);
+}
+
+// INPUT: Thread number, sublist, +1 for an insert or -1 for a delete
+// Keep the sublist's element count, so lengths need no walk. A sublist
+// behind a lock counts in the sublist itself, but lists that sync
+// themselves are updated concurrently, so each thread keeps its own row
+// of counts and a length is the sum of the rows
+void count_element(int my_num, int head_num, int delta)
+{
+	long long* c = size_counts ? &size_counts[my_num * size_stride + head_num]
+							   : &lists[head_num]->size;
+	__atomic_store_n(c, *c + delta, __ATOMIC_RELAXED);
+}
+
+// INPUT: Sublist
+// Return the number of elements in the sublist from its counts
+long long list_size(int head_num)
+{
+	if (size_counts == NULL)
+		return __atomic_load_n(&lists[head_num]->size, __ATOMIC_RELAXED);
+
+	long long size = 0;
+	int t;
+	for (t = 0; t < num_threads; t++)
+	{
+		size += __atomic_load_n(&size_counts[t * size_stride + head_num], __ATOMIC_RELAXED);
+	}
+	return size;
+}
+
+// INPUT: Thread number, sublist, request type, element and/or key
+// Publish a list operation, then either combine or wait to be served
+// Return the slot holding the result of the operation
+struct fc_slot* fc_execute(int my_num, int head_num, int op,
+						   SortedListElement_t* element, const char* key,
+						   long long* my_wait)
+{
+	struct fc_slot* slots = &fc_slots[head_num * num_threads];
+	struct fc_slot* mine = &slots[my_num];
+	mine->element = element;
+	mine->key = key;
+
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	__atomic_store_n(&mine->op, op, __ATOMIC_RELEASE);
+
+	int combiner = 0;
+	while (__atomic_load_n(&mine->op, __ATOMIC_ACQUIRE))
+	{
+		if (__atomic_load_n(&lists[head_num]->lock, __ATOMIC_RELAXED) == 0 &&
+			!__sync_lock_test_and_set(&lists[head_num]->lock, 1))
+		{
+			combiner = 1;
+			break;
+		}
+		cpu_relax();
+	}
+
+	struct timespec ending;
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+	*my_wait += get_time_dif(starting, ending);
+
+	if (!combiner)
+		return mine;
+
+	// Apply every published request for this sublist in one pass
+	int i;
+	for (i = 0; i < num_threads; i++)
+	{
+		int req = __atomic_load_n(&slots[i].op, __ATOMIC_ACQUIRE);
+		if (req == OP_INSERT)
+		{
+			SortedList_insert(head[head_num], slots[i].element);
+			count_element(my_num, head_num, 1);
+		}
+		else if (req == OP_LOOKUP)
+			slots[i].result = SortedList_lookup(head[head_num], slots[i].key);
+		else if (req == OP_DELETE)
+		{
+			slots[i].err = SortedList_delete(slots[i].element);
+			if (slots[i].err == 0)
+				count_element(my_num, head_num, -1);
+		}
+		else if (req == OP_REMOVE)
+		{
+			slots[i].result = SortedList_remove(head[head_num], slots[i].key);
+			if (slots[i].result)
+				count_element(my_num, head_num, -1);
+		}
+
+		if (req)
+			__atomic_store_n(&slots[i].op, 0, __ATOMIC_RELEASE);
+	}
+
+	__sync_lock_release(&lists[head_num]->lock);
+	return mine;
+}
+
+void spin_acquire(int* l)
+{
+	while(__sync_lock_test_and_set(l, 1));
+}
+
+void clh_release_node()
+{
+	clh_release(clh_me);
+	clh_me = clh_pred;
+}
+
+// Generate lock_<name> and unlock_<name> for one sync method, taking
+// the index of the sublist to acquire or release
+#define DEFINE_LIST_LOCK(name, acquire, release)	\
+	void lock_##name(int head_num)					\
+	{												\
+		acquire;									\
+	}												\
+													\
+	void unlock_##name(int head_num)				\
+	{												\
+		(void) head_num;							\
+		release;									\
+	}
+
+// Same for a reader-writer lock, also generating lock_shared_<name>
+// and unlock_shared_<name> for lookups and length scans
+#define DEFINE_LIST_RWLOCK(name, acquire, release, acquire_shared, release_shared)	\
+	DEFINE_LIST_LOCK(name, acquire, release)										\
+	DEFINE_LIST_LOCK(shared_##name, acquire_shared, release_shared)
+
+DEFINE_LIST_LOCK(none, (void) head_num, )
+DEFINE_LIST_LOCK(mutex, pthread_mutex_lock(&lists[head_num]->mutex),
+				 pthread_mutex_unlock(&lists[head_num]->mutex))
+DEFINE_LIST_LOCK(spin, spin_acquire(&lists[head_num]->lock),
+				 __sync_lock_release(&lists[head_num]->lock))
+DEFINE_LIST_LOCK(ttas, ttas_acquire(&lists[head_num]->lock),
+				 __sync_lock_release(&lists[head_num]->lock))
+DEFINE_LIST_LOCK(futex, futex_acquire(&lists[head_num]->lock),
+				 futex_release(&lists[head_num]->lock))
+DEFINE_LIST_LOCK(ticket, ticket_acquire(&lists[head_num]->ticket),
+				 ticket_release(&lists[head_num]->ticket))
+DEFINE_LIST_LOCK(mcs, mcs_acquire(&lists[head_num]->mcs, &mcs_me),
+				 mcs_release(&lists[head_num]->mcs, &mcs_me))
+DEFINE_LIST_LOCK(clh, clh_pred = clh_acquire(&lists[head_num]->clh, clh_me),
+				 clh_release_node())
+DEFINE_LIST_RWLOCK(rwlock, pthread_rwlock_wrlock(&lists[head_num]->rwlock),
+				   pthread_rwlock_unlock(&lists[head_num]->rwlock),
+				   pthread_rwlock_rdlock(&lists[head_num]->rwlock),
+				   pthread_rwlock_unlock(&lists[head_num]->rwlock))
+DEFINE_LIST_RWLOCK(br, br_write_acquire(lists[head_num]->br),
+				   br_write_release(lists[head_num]->br),
+				   br_read_acquire(lists[head_num]->br),
+				   br_read_release(lists[head_num]->br))
+
+// Sublist lock for each --sync letter. Plain locks are also taken by
+// readers, reader-writer locks give readers their shared side
+struct list_lock_variant {
+	char method;
+	void (*lock)(int head_num);
+	void (*unlock)(int head_num);
+	void (*lock_shared)(int head_num);
+	void (*unlock_shared)(int head_num);
+};
+
+#define LIST_LOCK(method, name) \
+	{method, lock_##name, unlock_##name, lock_##name, unlock_##name}
+#define LIST_RWLOCK(method, name) \
+	{method, lock_##name, unlock_##name, lock_shared_##name, unlock_shared_##name}
+
+const struct list_lock_variant list_lock_variants[] = {
+	LIST_LOCK('m', mutex),
+	LIST_LOCK('s', spin),
+	LIST_LOCK('b', ttas),
+	LIST_LOCK('p', futex),
+	LIST_LOCK('t', ticket),
+	LIST_LOCK('q', mcs),
+	LIST_LOCK('k', clh),
+	LIST_RWLOCK('r', rwlock),
+	LIST_LOCK(0, none)
+};
+
+// --sync=rw with --rwlock=br
+const struct list_lock_variant big_reader_variant = LIST_RWLOCK('r', br);
+
+// Chosen once per run by select_list_lock instead of checking the
+// sync method around every list operation
+void (*lock_list)(int head_num) = lock_none;
+void (*unlock_list)(int head_num) = unlock_none;
+void (*lock_list_shared)(int head_num) = lock_none;
+void (*unlock_list_shared)(int head_num) = unlock_none;
+
+// Pick the sublist lock for the current sync method
+// Flat combining and unknown letters take no sublist lock
+void select_list_lock()
+{
+	char method = sync_method ? *sync_method : 0;
+	const struct list_lock_variant* v = list_lock_variants;
+	while (v->method != 0 && v->method != method)
+		v++;
+	if (method == 'r' && opt_big_reader)
+		v = &big_reader_variant;
+
+	lock_list = v->lock;
+	unlock_list = v->unlock;
+	lock_list_shared = v->lock_shared;
+	unlock_list_shared = v->unlock_shared;
+}
+
 void signal_handler(int num)
 {
 	if (num == SIGSEGV)
@@ -52,10 +926,119 @@ void signal_handler(int num)
 	}
 }
 
+// INPUT: Array for one file descriptor per counter
+// Open this thread's hardware counters, disabled until perf_start
+// A counter the hardware or kernel does not offer is left at -1
+void perf_open(int* fds)
+{
+	struct perf_event_attr attr;
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.disabled = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		if (i == PERF_CYCLES)
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		else if (i == PERF_INSTRUCTIONS)
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		else if (i == PERF_LLC_MISSES)
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		else
+		{
+			// There is no generic event for snoop hits on modified lines,
+			// so transfers are only counted when the raw code is given
+			fds[i] = -1;
+			if (perf_raw_transfers == 0)
+				continue;
+			attr.type = PERF_TYPE_RAW;
+			attr.config = perf_raw_transfers;
+		}
+
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+		// Unprivileged users may only count user space
+		if (fds[i] == -1 && (errno == EACCES || errno == EPERM))
+		{
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+	}
+}
+
+// Reset and start every counter opened by perf_open
+void perf_start(int* fds)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (fds[i] != -1)
+		{
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+// INPUT: Counters from perf_open, where to store their values
+// Stop and close the counters, scaling for time lost to multiplexing
+void perf_stop(int* fds, struct perf_counts* counts)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		counts->value[i] = -1;
+		if (fds[i] == -1)
+			continue;
+
+		ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		// value, time enabled, time running
+		unsigned long long data[3];
+		if (read(fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0)
+		{
+			counts->value[i] = (long long) ((double) data[0] * data[1] / data[2]);
+		}
+		close(fds[i]);
+	}
+}
+
+// Add the counts of one thread into a total, a counter missing in
+// either stays missing
+void perf_merge(struct perf_counts* into, struct perf_counts* from)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (into->value[i] == -1 || from->value[i] == -1)
+			into->value[i] = -1;
+		else
+			into->value[i] += from->value[i];
+	}
+}
+
+// INPUT: Summed counts and the number of operations they cover
+// Print the counts per operation as CSV columns, NA for missing counters
+void perf_print(struct perf_counts* counts, long long operations)
+{
+	int i;
+	for (i = 0; i < NUM_PERF; i++)
+	{
+		if (counts->value[i] == -1)
+			printf(",NA");
+		else
+			printf(",%.3f", (double) counts->value[i] / operations);
+	}
+}
+
 // INPUT: Info about CL arguments, strings for argument parameters
 // Process CL arguments while checking for invalid options
-void process_cl_arugments(int argc, char** argv,
-						  char** threads, char** iterations, char** str_yield)
+void process_cl_arugments(int argc, char** argv, char** threads,
+						  char** iterations, char** str_yield, char** str_lists)
 {
 	struct option long_options[] =
 	{
@@ -64,6 +1047,23 @@ void process_cl_arugments(int argc, char** argv,
 		{"yield", required_argument, NULL, 'y'},
 		{"sync", required_argument, NULL, 's'},
 		{"lists", required_argument, NULL, 'l'},
+		{"impl", required_argument, NULL, 'I'},
+		{"rwlock", required_argument, NULL, 'W'},
+		{"reads", required_argument, NULL, 'R'},
+		{"backoff", required_argument, NULL, 'b'},
+		{"spin", required_argument, NULL, 'p'},
+		{"latency", no_argument, NULL, 'L'},
+		{"affinity", required_argument, NULL, 'a'},
+		{"numa", required_argument, NULL, 'n'},
+		{"duration", required_argument, NULL, 'd'},
+		{"sweep", no_argument, NULL, 'S'},
+		{"reps", required_argument, NULL, 'r'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"perf", optional_argument, NULL, 'P'},
+		{"seed", required_argument, NULL, 'e'},
+		{"validate", no_argument, NULL, 'V'},
+		{"batch", required_argument, NULL, 'B'},
+		{"remove", no_argument, NULL, 'X'},
 		{0, 0, 0, 0}
 	};
 	int option_index = 0;
@@ -91,72 +1091,421 @@ void process_cl_arugments(int argc, char** argv,
 			case 's':
 				sync_method = optarg;
 				break;
+			case 'I':
+				list_impl = optarg;
+				if (SortedList_set_impl(list_impl) == -1)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --impl must be linear, skiplist, lockfree, handoverhand, lazy, inline or unrolled.");
+					exit(ERR_CODE);
+				}
+				break;
+			case 'W':
+				if (strcmp(optarg, "pthread") != 0 && strcmp(optarg, "br") != 0)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --rwlock must be pthread or br.");
+					exit(ERR_CODE);
+				}
+				opt_big_reader = strcmp(optarg, "br") == 0;
+				break;
+			case 'R':
+			{
+				// Every element is inserted, looked up and deleted once,
+				// extra lookups raise the share of reads to the given percent
+				double reads = atof(optarg) / 100;
+				if (reads < 0 || reads >= 1)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --reads must be at least 0 and below 100.");
+					exit(ERR_CODE);
+				}
+				lookups_per_element = reads > 1.0 / 3 ? (3 * reads - 1) / (1 - reads) : 0;
+				break;
+			}
 			case 'l':
+				*str_lists = optarg;
 				num_lists = atoi(optarg);
 				break;
+			case 'b':
+				backoff_cap = atoi(optarg);
+				break;
+			case 'p':
+				spin_limit = atoi(optarg);
+				break;
+			case 'L':
+				opt_latency = 1;
+				break;
+			case 'a':
+				affinity = optarg;
+				break;
+			case 'd':
+				duration = atof(optarg);
+				break;
+			case 'S':
+				opt_sweep = 1;
+				break;
+			case 'r':
+				sweep_reps = atoi(optarg);
+				break;
+			case 'w':
+				sweep_warmup = atoi(optarg);
+				break;
+			case 'P':
+				opt_perf = 1;
+				if (optarg)
+					perf_raw_transfers = strtoull(optarg, NULL, 0);
+				break;
+			case 'V':
+				opt_validate = 1;
+				break;
+			case 'X':
+				opt_remove = 1;
+				break;
+			case 'B':
+				batch_size = atoi(optarg);
+				if (batch_size < 1)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --batch must be at least 1.");
+					exit(ERR_CODE);
+				}
+				break;
+			case 'e':
+				seed = strtoull(optarg, NULL, 0);
+				break;
+			case 'n':
+				numa_policy = optarg;
+				if (strcmp(numa_policy, "local") != 0 && strcmp(numa_policy, "interleave") != 0)
+				{
+					fprintf(stderr, "%s\n", "ERROR: --numa must be local or interleave.");
+					exit(ERR_CODE);
+				}
+				break;
 			case '?':
 				fprintf(stderr, "%s\n", "ERROR: Invalid argument.");
-				fprintf(stderr, "%s\n", "Usage: lab2a_add [--threads=#] [--iterations=#] [--yield=[idl]] [--sync=[ms]] [--lists=#]");
+				fprintf(stderr, "%s\n", "Usage: lab2a_add [--threads=#] [--iterations=#] [--yield=[idl]] [--sync=[mstqkbpohz]|lf|rw] [--rwlock=pthread|br] [--reads=#] [--lists=#] [--impl=linear|skiplist|lockfree|handoverhand|lazy|inline|unrolled] [--backoff=#] [--spin=#] [--latency] [--affinity=compact|scatter|#,#-#] [--numa=local|interleave] [--duration=#] [--sweep [--reps=#] [--warmup=#]] [--perf[=raw]] [--seed=#] [--validate] [--batch=#] [--remove]");
 				exit(ERR_CODE);
 		}
 	}
 }
 
-// Generate a random 20 char alphanumeric key
-char* generate_random_key()
+// 128-bit multiply folded to 64 bits, the mixing step of wyhash
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+	__uint128_t r = (__uint128_t) a * b;
+	return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
+
+// INPUT: Key to hash
+// wyhash-style hash, eight bytes per multiply
+uint64_t hash_key(const char* key)
+{
+	const uint64_t p0 = 0xa0761d6478bd642fULL;
+	const uint64_t p1 = 0xe7037ed1a0b428dbULL;
+	size_t len = strlen(key);
+	uint64_t h = p0 ^ len;
+
+	size_t i;
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		uint64_t chunk;
+		memcpy(&chunk, key + i, 8);
+		h = hash_mix(h ^ chunk, p1);
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, key + i, len - i);
+	return hash_mix(h ^ tail ^ p1, p0 ^ len);
+}
+
+// wyrand: a counter stepped by an odd constant, then mixed
+static inline uint64_t wyrand(uint64_t* state)
+{
+	*state += 0xa0761d6478bd642fULL;
+	return hash_mix(*state, *state ^ 0xe7037ed1a0b428dbULL);
+}
+
+// Fill a buffer of KEY_LEN + 1 bytes with a random alphanumeric key
+// Each draw gives 10 base 36 digits, few enough to keep the bias tiny
+void fill_random_key(char* key, uint64_t* state)
+{
+	static const char alphanum[] = {"0123456789abcdefghijklmnopqrstuvwxyz"};
+
+	uint64_t r = 0;
+	int i;
+	for (i = 0; i < KEY_LEN; i++)
+	{
+		if (i % 10 == 0)
+			r = wyrand(state);
+		key[i] = alphanum[r % (sizeof(alphanum) - 1)];
+		r /= sizeof(alphanum) - 1;
+	}
+	key[KEY_LEN] = 0;
+}
+
+// INPUT: Key of an element
+// Return the sublist that holds the key, so any thread can find any key
+int key_list(const char* key)
+{
+	return hash_key(key) % num_lists;
+}
+
+// INPUT: Setup arguments of one thread
+// Fill in the thread's block of the arena, elements followed by their keys,
+// from a generator seeded by --seed and the thread id. With --numa=local
+// the block is mapped here so it is first touched on the thread's node
+void* setup_block(void* args)
+{
+	struct setup_args* my_args = (struct setup_args *) args;
+	int t = my_args->thread_id;
+
+	char* elements;
+	if (numa_blocks)
+	{
+		numa_blocks[t] = alloc_on_node(my_args->block_size, cpu_node(thread_cpu[t]));
+		elements = (char *) numa_blocks[t];
+	}
+	else
+	{
+		elements = element_arena + t * my_args->block_size;
+		memset(elements, 0, my_args->block_size);
+	}
+	char* keys = elements + my_args->per_thread * SortedList_element_size;
+
+	uint64_t state = seed + (t + 1) * 0x9e3779b97f4a7c15ULL;
+
+	// The block is zero filled, so only the keys need setting
+	long long k;
+	for (k = 0; k < my_args->per_thread; k++)
+	{
+		SortedListElement_t* element = (SortedListElement_t *) (elements + k * SortedList_element_size);
+		fill_random_key(&keys[k * (KEY_LEN + 1)], &state);
+		element->key = &keys[k * (KEY_LEN + 1)];
+		my_args->list_elements[t + k * num_threads] = element;
+	}
+	return NULL;
+}
+
+// INPUT: Thread to start, its index, start routine and argument
+// Create the thread, pinned to its CPU from --affinity if there is one
+void create_pinned_thread(pthread_t* thread, int i, void* (*routine)(void *), void* arg)
+{
+	// Pin through the attributes so the thread never runs elsewhere
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	if (thread_cpu)
+	{
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(thread_cpu[i], &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+	}
+
+	if (pthread_create(thread, &attr, routine, arg) != 0)
+	{
+		process_failed_sys_call("pthread_create");
+	}
+	pthread_attr_destroy(&attr);
+}
+
+// INPUT: Number of list nodes to allocate
+// Return a pointer to a list of pointers to list nodes
+// Thread t uses elements t, t + threads, ... so every thread gets one
+// block of the arena, which that thread's setup_block fills in parallel
+SortedListElement_t** generate_list_nodes(long long count)
+{
+	SortedListElement_t** list_elements = (SortedListElement_t **) malloc(sizeof(SortedList_t*) * count);
+	if (list_elements == NULL)
+	{
+		process_failed_sys_call("malloc");
+	}
+
+	// Blocks start on cache lines, so every element is as aligned as
+	// its size allows, which marked pointers and futexes depend on
+	long long per_thread = count / num_threads;
+	size_t block_size = per_thread * (SortedList_element_size + KEY_LEN + 1);
+	block_size = (block_size + 63) & ~(size_t) 63;
+
+	if (numa_policy && *numa_policy == 'l')
+	{
+		numa_block_size = block_size;
+		numa_blocks = (void **) malloc(sizeof(void *) * num_threads);
+		if (numa_blocks == NULL)
+		{
+			process_failed_sys_call("malloc");
+		}
+	}
+	else
+	{
+		if (posix_memalign((void **) &element_arena, 64, num_threads * block_size) != 0)
+		{
+			process_failed_sys_call("posix_memalign");
+		}
+	}
+
+	pthread_t* threads = (pthread_t *) malloc(sizeof(pthread_t) * num_threads);
+	struct setup_args* s_args = (struct setup_args *) malloc(sizeof(struct setup_args) * num_threads);
+	if (threads == NULL || s_args == NULL)
+	{
+		process_failed_sys_call("malloc");
+	}
+
+	int t;
+	for (t = 0; t < num_threads; t++)
+	{
+		s_args[t].thread_id = t;
+		s_args[t].per_thread = per_thread;
+		s_args[t].block_size = block_size;
+		s_args[t].list_elements = list_elements;
+		create_pinned_thread(&threads[t], t, setup_block, &s_args[t]);
+	}
+
+	for (t = 0; t < num_threads; t++)
+	{
+		if (pthread_join(threads[t], NULL) != 0)
+		{
+			process_failed_sys_call("pthread_join");
+		}
+	}
+	free(threads);
+	free(s_args);
+	return list_elements;
+}
+
+// Small xorshift generator, one state per thread
+unsigned int next_random(unsigned int* state)
 {
-	int key_len = 20;
-	char* key = (char *) malloc(sizeof(char) * key_len);
-	if (key == NULL)
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// INPUT: Thread number
+// Wait until every other thread has left the list phase it was in, so
+// none can still hold a pointer to an element this thread deleted
+// Return 0 if the run was stopped while waiting, 1 otherwise
+int wait_for_quiescence(int my_num)
+{
+	int t;
+	for (t = 0; t < num_threads; t++)
 	{
-		process_failed_sys_call("malloc");
+		int seen = __atomic_load_n(&phase_slots[t].count, __ATOMIC_SEQ_CST);
+		if (t == my_num || (seen & 1) == 0)
+			continue;
+
+		while (__atomic_load_n(&phase_slots[t].count, __ATOMIC_ACQUIRE) == seen)
+		{
+			if (__atomic_load_n(&stop_flag, __ATOMIC_RELAXED))
+				return 0;
+			sched_yield();
+		}
 	}
-	char alphanum[] = {"0123456789abcdefghijklmnopqrstuvwxyz"};
+	return 1;
+}
 
-	int i;
-	for (i = 0; i < key_len; i++)
+// INPUT: Thread arguments, sublist, elements waiting for it, how many
+// Sort a batch of elements, then insert it under one acquisition of the
+// sublist lock, so the sort is not part of the critical section
+void insert_batch(struct thread_args* my_args, int head_num,
+				  SortedListElement_t** elements, int n)
+{
+	struct timespec op_start;
+	start_latency(&op_start);
+
+	SortedList_sort_batch(elements, n);
+
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	lock_list(head_num);
+
+	struct timespec ending;
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
 	{
-		key[i] = alphanum[rand() % (sizeof(alphanum) - 1)];
+		process_failed_sys_call("clock_gettime");
 	}
-	key[key_len] = 0;
 
-	return key;
+	my_args->my_wait += get_time_dif(starting, ending);
+
+	SortedList_insert_batch(head[head_num], elements, n);
+	count_element(my_args->thread_id, head_num, n);
+
+	unlock_list(head_num);
+
+	record_latency(my_args, OP_INSERT, op_start);
 }
 
-// INPUT: Number of list nodes to allocate
-// Return a pointer to a list of pointers to list nodes
-SortedListElement_t** generate_list_nodes(long long count)
+// INPUT: Thread arguments, sublist, key, whether flat combining is on
+// Find and delete the element with a key under one acquisition of the
+// sublist lock, adding the time spent waiting for it to the wait time
+SortedListElement_t* remove_key(struct thread_args* my_args, int head_num,
+								const char* key, int combining)
 {
-	SortedListElement_t** list_elements = (SortedListElement_t **) malloc(sizeof(SortedList_t*) * count);
-	if (list_elements == NULL)
+	if (combining)
 	{
-		process_failed_sys_call("malloc");
+		return fc_execute(my_args->thread_id, head_num, OP_REMOVE, NULL, key,
+						  &my_args->my_wait)->result;
 	}
 
-	long long i;
-	for (i = 0; i < count; i++)
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
 	{
-		list_elements[i] = (SortedListElement_t *) malloc(sizeof(SortedListElement_t));
-		if (list_elements[i] == NULL)
-		{
-			process_failed_sys_call("malloc");
-		}
+		process_failed_sys_call("clock_gettime");
+	}
 
-		list_elements[i]->key = generate_random_key();
-		list_elements[i]->prev = NULL;
-		list_elements[i]->next = NULL;
+	lock_list(head_num);
+
+	struct timespec ending;
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
 	}
-	return list_elements;
+
+	my_args->my_wait += get_time_dif(starting, ending);
+
+	SortedListElement_t* removed = SortedList_remove(head[head_num], key);
+	if (removed)
+		count_element(my_args->thread_id, head_num, -1);
+
+	unlock_list(head_num);
+	return removed;
 }
 
-long get_time_dif(struct timespec starting, struct timespec ending)
+// INPUT: Thread arguments, sublist, key, whether flat combining is on
+// Look up a key under the shared side of the sublist lock, adding the
+// time spent waiting for it to the thread's wait time
+SortedListElement_t* read_lookup(struct thread_args* my_args, int head_num,
+								 const char* key, int combining)
 {
-	long run_time = ending.tv_nsec - starting.tv_nsec;
-	if (run_time < 0)
+	if (combining)
 	{
-		run_time += 1000000000;
+		return fc_execute(my_args->thread_id, head_num, OP_LOOKUP, NULL, key,
+						  &my_args->my_wait)->result;
 	}
-	return run_time;
+
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	lock_list_shared(head_num);
+
+	struct timespec ending;
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	my_args->my_wait += get_time_dif(starting, ending);
+
+	SortedListElement_t* elem = SortedList_lookup(head[head_num], key);
+
+	unlock_list_shared(head_num);
+	return elem;
 }
 
 void* update_list(void* args)
@@ -171,6 +1520,16 @@ void* update_list(void* args)
 	long long count = my_args->num_elements;
 	long long threads = count / iter;
 
+	if (sync_method && *sync_method == 'k')
+		clh_me = &clh_nodes[my_num];
+
+	// Decided once so the loops below only test a local
+	int combining = sync_method && *sync_method == 'o';
+
+	// Picks the keys of extra --reads lookups
+	unsigned int rng = my_num + 1;
+	double extra_credit = 0;
+
 	struct key_pair {
 		const char* key;
 		int head_location;
@@ -182,199 +1541,543 @@ void* update_list(void* args)
 		process_failed_sys_call("malloc");
 	}
 
-	// printf("%s\n", "INSERTING");
-	long long i;
-	int j;
-	for (i = my_num, j = 0; i < count; i += threads, j++)
+	// With --batch, inserts wait per sublist until a batch is full.
+	// Flat combining already applies inserts in batches
+	int batching = batch_size > 1 && !combining;
+	SortedListElement_t** pending = NULL;
+	int* num_pending = NULL;
+	if (batching)
 	{
-		int head_num = my_num % num_lists;
-
-		struct timespec starting;
-		if (clock_gettime(CLOCK_REALTIME, &starting) == -1)
+		pending = (SortedListElement_t **) malloc(sizeof(SortedListElement_t *) * num_lists * batch_size);
+		num_pending = (int *) calloc(num_lists, sizeof(int));
+		if (pending == NULL || num_pending == NULL)
 		{
-			process_failed_sys_call("clock_gettime");
+			process_failed_sys_call("malloc");
 		}
+	}
+
+	int perf_fds[NUM_PERF];
+	if (opt_perf)
+		perf_open(perf_fds);
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_lock(&mutex[head_num]);
+	// Wait until every thread exists so none starts out uncontended,
+	// then again for main to start the clock and release everyone
+	pthread_barrier_wait(&start_barrier);
+	pthread_barrier_wait(&start_barrier);
 
-		if (sync_method && *sync_method == 's')
-			while(__sync_lock_test_and_set(&lock[head_num], 1));
+	if (opt_perf)
+		perf_start(perf_fds);
 
-		struct timespec ending;
-		if (clock_gettime(CLOCK_REALTIME, &ending) == -1)
+	// With --duration, repeat whole insert/lookup/delete rounds until
+	// main raises the stop flag, so the lists are empty when we stop
+	// printf("%s\n", "INSERTING");
+	long long i;
+	int j;
+	do
+	{
+		// Lists without a sublist lock have no grace period, so before
+		// reinserting last round's elements wait for every operation
+		// that could have seen them deleted to finish
+		if (phase_slots)
 		{
-			process_failed_sys_call("clock_gettime");
+			if (my_args->rounds > 0 && !wait_for_quiescence(my_num))
+				break;
+			__atomic_fetch_add(&phase_slots[my_num].count, 1, __ATOMIC_SEQ_CST);
 		}
 
-		my_args->my_wait += get_time_dif(starting, ending);
+		for (i = my_num, j = 0; i < count; i += threads, j++)
+		{
+			int head_num = key_list(list_elements[i]->key);
+
+			keys[j].key = list_elements[i]->key;
+			keys[j].head_location = head_num;
+
+			if (batching)
+			{
+				SortedListElement_t** batch = &pending[head_num * batch_size];
+				batch[num_pending[head_num]++] = list_elements[i];
+				if (num_pending[head_num] == batch_size)
+				{
+					insert_batch(my_args, head_num, batch, batch_size);
+					num_pending[head_num] = 0;
+				}
+				continue;
+			}
+
+			struct timespec op_start;
+			start_latency(&op_start);
+
+			if (combining)
+			{
+				fc_execute(my_num, head_num, OP_INSERT, list_elements[i], NULL, &my_args->my_wait);
+			}
+			else
+			{
+				struct timespec starting;
+				if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+				{
+					process_failed_sys_call("clock_gettime");
+				}
+
+				lock_list(head_num);
+
+				struct timespec ending;
+				if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
+				{
+					process_failed_sys_call("clock_gettime");
+				}
+
+				my_args->my_wait += get_time_dif(starting, ending);
+
+				SortedList_insert(head[head_num], list_elements[i]);
+				count_element(my_num, head_num, 1);
+
+				unlock_list(head_num);
+			}
+
+			record_latency(my_args, OP_INSERT, op_start);
+		}
 
-		SortedList_insert(head[head_num], list_elements[i]);
+		// Insert what is left of every sublist's batch
+		if (batching)
+		{
+			for (i = 0; i < num_lists; i++)
+			{
+				if (num_pending[i] > 0)
+					insert_batch(my_args, i, &pending[i * batch_size], num_pending[i]);
+				num_pending[i] = 0;
+			}
+		}
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_unlock(&mutex[head_num]);
+		// printf("%s\n", "LENGTH");
+		// --validate walks every sublist, otherwise the counts are summed
+		int len = 0;
+		for (i = 0; i < num_lists; i++)
+		{
+			if (!opt_validate)
+			{
+				len += list_size(i);
+				continue;
+			}
+			// Under flat combining, holding the combiner lock keeps
+			// other threads' requests out of the sublist
+			if (combining)
+				spin_acquire(&lists[i]->lock);
+			else
+				lock_list_shared(i);
+			len += SortedList_length(head[i]);
+			if (combining)
+				__sync_lock_release(&lists[i]->lock);
+			else
+				unlock_list_shared(i);
+		}
 
-		if (sync_method && *sync_method == 's')
-			__sync_lock_release(&lock[head_num]);
+		if (len == 0)
+		{
+			fprintf(stderr, "%s\n", "ERROR: Nodes were not correctly inserted into list.");
+			fprintf(stderr, "There should be %d nodes but there are actually %d\n", iter, len);
+			pthread_exit((void *)FAIL_CODE);
+		}
 
-		keys[j].key = list_elements[i]->key;
-		keys[j].head_location = head_num;
-	}
+		// printf("%s\n", "LOOKUP/DELETE");
+		for (j = 0; j < iter; j++)
+		{
+			int head_num = keys[j].head_location;
+
+			// With --reads, look up keys of ours that are still in the
+			// lists before the lookup that finds the element to delete
+			extra_credit += lookups_per_element;
+			while (extra_credit >= 1)
+			{
+				int k = j + next_random(&rng) % (iter - j);
+				struct timespec op_start;
+				start_latency(&op_start);
+				read_lookup(my_args, keys[k].head_location, keys[k].key, combining);
+				record_latency(my_args, OP_LOOKUP, op_start);
+				my_args->extra_lookups++;
+				extra_credit -= 1;
+			}
+
+			struct timespec op_start;
+			start_latency(&op_start);
+
+			// With --remove the lookup and delete are one operation
+			// under one exclusive acquisition, timed as the delete
+			if (opt_remove)
+			{
+				SortedListElement_t* removed = remove_key(my_args, head_num, keys[j].key, combining);
+				record_latency(my_args, OP_DELETE, op_start);
+				if (removed == NULL)
+				{
+					fprintf(stderr, "%s\n", "ERROR: Node removal failed.");
+					fprintf(stderr, "There should be a node with key %s but it was not removed.\n", keys[j].key);
+					pthread_exit((void *)FAIL_CODE);
+				}
+				continue;
+			}
+
+			SortedListElement_t* elem = read_lookup(my_args, head_num, keys[j].key, combining);
+			record_latency(my_args, OP_LOOKUP, op_start);
+			if (elem == NULL)
+			{
+				fprintf(stderr, "%s\n", "ERROR: Node lookup failed.");
+				fprintf(stderr, "There should be a node with key %s but none was found.\n", keys[j].key);
+				pthread_exit((void *)FAIL_CODE);
+			}
+
+			// Flat combining hands the delete to the combiner instead
+			if (combining)
+			{
+				start_latency(&op_start);
+				int err = fc_execute(my_num, head_num, OP_DELETE, elem, NULL, &my_args->my_wait)->err;
+				record_latency(my_args, OP_DELETE, op_start);
+
+				if (err == 1)
+				{
+					fprintf(stderr, "%s\n", "ERROR: Node deletion failed.");
+					fprintf(stderr, "The node with key %s had corrupted next/prev pointers.", elem->key);
+					pthread_exit((void *)FAIL_CODE);
+				}
+				continue;
+			}
+
+			start_latency(&op_start);
+
+			struct timespec starting;
+			if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+			{
+				process_failed_sys_call("clock_gettime");
+			}
+
+			lock_list(head_num);
+
+			struct timespec ending;
+			if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
+			{
+				process_failed_sys_call("clock_gettime");
+			}
+
+			my_args->my_wait += get_time_dif(starting, ending);
+
+			int err = SortedList_delete(elem);
+			if (err == 0)
+				count_element(my_num, head_num, -1);
+
+			unlock_list(head_num);
+
+			record_latency(my_args, OP_DELETE, op_start);
+
+			if (err == 1)
+			{
+				fprintf(stderr, "%s\n", "ERROR: Node deletion failed.");
+				fprintf(stderr, "The node with key %s had corrupted next/prev pointers.", elem->key);
+				pthread_exit((void *)FAIL_CODE);
+			}
+		}
 
-	// printf("%s\n", "LENGTH");
-	int len = 0;
-	for (i = 0; i < num_lists; i++)
-	{
-		len += SortedList_length(head[i]);
-	}
+		if (phase_slots)
+			__atomic_fetch_add(&phase_slots[my_num].count, 1, __ATOMIC_SEQ_CST);
 
-	if (len == 0)
-	{
-		fprintf(stderr, "%s\n", "ERROR: Nodes were not correctly inserted into list.");
-		fprintf(stderr, "There should be %d nodes but there are actually %d\n", iter, len);
-		pthread_exit((void *)FAIL_CODE);
-	}
+		my_args->rounds++;
+	} while (duration > 0 && !__atomic_load_n(&stop_flag, __ATOMIC_RELAXED));
 
-	// printf("%s\n", "LOOKUP/DELETE");
-	for (j = 0; j < iter; j++)
-	{
-		int head_num = keys[j].head_location;
+	if (opt_perf)
+		perf_stop(perf_fds, &my_args->perf);
 
-		struct timespec starting;
-		if (clock_gettime(CLOCK_REALTIME, &starting) == -1)
-		{
-			process_failed_sys_call("clock_gettime");
-		}
+	free(keys);
+	free(pending);
+	free(num_pending);
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_lock(&mutex[head_num]);
+	pthread_exit(NULL);
+}
 
-		if (sync_method && *sync_method == 's')
-			while(__sync_lock_test_and_set(&lock[head_num], 1));
+// Return the list implementation the sync method requires, or NULL
+const char* list_forced_by_sync()
+{
+	if (sync_method && strcmp(sync_method, "lf") == 0)
+		return "lockfree";
+	if (sync_method && strcmp(sync_method, "h") == 0)
+		return "handoverhand";
+	if (sync_method && strcmp(sync_method, "z") == 0)
+		return "lazy";
+	return NULL;
+}
 
-		struct timespec ending;
-		if (clock_gettime(CLOCK_REALTIME, &ending) == -1)
-		{
-			process_failed_sys_call("clock_gettime");
-		}
+// INPUT: Buffer for the name, its size, length so far, format and values
+// Append to a test name, stopping once the buffer is full
+void append_name(char* name, size_t size, size_t* n, const char* format, ...)
+{
+	if (*n >= size)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(name + *n, size - *n, format, args);
+	va_end(args);
+	if (written > 0)
+		*n += written;
+}
 
-		my_args->my_wait += get_time_dif(starting, ending);
+// INPUT: Buffer for the name, its size, the --yield argument
+// Build the name of the test from the current yield and sync settings
+void build_test_name(char* name, size_t size, char* str_yield)
+{
+	size_t n = 0;
+	append_name(name, size, &n, "list-%s-%s", str_yield ? str_yield : "none",
+				sync_method ? sync_method : "none");
+
+	// Reader-writer variants and read-heavy mixes get their own series
+	if (sync_method && *sync_method == 'r' && opt_big_reader)
+		append_name(name, size, &n, "-br");
+	// --sync=lf, h and z pick the list themselves, which the sync
+	// part of the name already says
+	if (list_impl && !list_forced_by_sync())
+		append_name(name, size, &n, "-%s", list_impl);
+	if (batch_size > 1 && !(sync_method && *sync_method == 'o'))
+		append_name(name, size, &n, "-batch%d", batch_size);
+	if (opt_remove)
+		append_name(name, size, &n, "-remove");
+	if (lookups_per_element > 0)
+		append_name(name, size, &n, "-reads%.0f",
+					100 * (1 + lookups_per_element) / (3 + lookups_per_element));
+}
 
-		SortedListElement_t* elem = SortedList_lookup(head[head_num], keys[j].key);
+// Two-sided 95% Student t critical value for the degrees of freedom
+double t_critical(int df)
+{
+	static const double table[] = {
+		0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	if (df < 1)
+		return 0;
+	if (df <= 30)
+		return table[df];
+	return 1.960;
+}
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_unlock(&mutex[head_num]);
+// INPUT: Samples, how many there are, where to store their mean
+// Return the half width of the 95% confidence interval of the mean
+double confidence_interval(double* samples, int n, double* mean)
+{
+	double sum = 0;
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		sum += samples[i];
+	}
+	*mean = sum / n;
 
-		if (sync_method && *sync_method == 's')
-			__sync_lock_release(&lock[head_num]);
+	if (n < 2)
+		return 0;
 
-		if (elem == NULL)
-		{
-			fprintf(stderr, "%s\n", "ERROR: Node lookup failed.");
-			fprintf(stderr, "There should be a node with key %s but none was found.\n", keys[j].key);
-			pthread_exit((void *)FAIL_CODE);
-		}
+	double squares = 0;
+	for (i = 0; i < n; i++)
+	{
+		squares += (samples[i] - *mean) * (samples[i] - *mean);
+	}
+	return t_critical(n - 1) * sqrt(squares / (n - 1)) / sqrt(n);
+}
 
-		if (clock_gettime(CLOCK_REALTIME, &starting) == -1)
+// INPUT: Comma separated numbers or ranges such as 1,2,4-8
+// Fill values from the list and return how many there are
+int parse_int_list(const char* str, int* values)
+{
+	int n = 0;
+	const char* p = str;
+	while (*p && n < MAX_SWEEP)
+	{
+		char* end;
+		int first = strtol(p, &end, 10);
+		int last = first;
+		if (*end == '-')
+			last = strtol(end + 1, &end, 10);
+
+		int v;
+		for (v = first; v <= last && n < MAX_SWEEP; v++)
 		{
-			process_failed_sys_call("clock_gettime");
+			values[n++] = v;
 		}
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_lock(&mutex[head_num]);
+		p = end;
+		if (*p != ',')
+			break;
+		p++;
+	}
+	return n;
+}
 
-		if (sync_method && *sync_method == 's')
-			while(__sync_lock_test_and_set(&lock[head_num], 1));
+// INPUT: Information about the test that was just run
+// Print to STDOUT a CSV record about the test
+// With --sweep, ci holds the 95% interval for the run time and time / operation
+void print_results(char test_name[], int num_iterations, long long num_operations,
+				   long long run_time, long long lock_waiting_time, double skew,
+				   long long setup_time, struct latency_hist* hist, struct perf_counts* perf, double* ci)
+{
+	// name, # threads, # iterations, # lists, # operations, run time,
+	// time / operation, wait-for-lock time / operation, list occupancy skew,
+	// key generation time
+	printf("%s,", test_name);
+	printf("%d%s", num_threads, ",");
+	printf("%d%s", num_iterations, ",");
+	printf("%d%s", num_lists, ",");
+	printf("%lld%s", num_operations, ",");
+	printf("%lld%s", run_time, ",");
 
-		if (clock_gettime(CLOCK_REALTIME, &ending) == -1)
-		{
-			process_failed_sys_call("clock_gettime");
-		}
+	long long avg_time_per_operation = run_time / num_operations;
 
-		my_args->my_wait += get_time_dif(starting, ending);
+	printf("%lld,", avg_time_per_operation);
 
-		int err = SortedList_delete(elem);
+	printf("%lld,", lock_waiting_time / num_operations);
 
-		if (sync_method && *sync_method == 'm')
-			pthread_mutex_unlock(&mutex[head_num]);
+	printf("%.3f,", skew);
 
-		if (sync_method && *sync_method == 's')
-			__sync_lock_release(&lock[head_num]);
+	printf("%lld", setup_time);
 
-		if (err == 1)
+	// With --latency: p50, p99, p99.9 for insert, then lookup, then delete
+	if (hist)
+	{
+		int j;
+		for (j = 0; j < NUM_OPS; j++)
 		{
-			fprintf(stderr, "%s\n", "ERROR: Node deletion failed.");
-			fprintf(stderr, "The node with key %s had corrupted next/prev pointers.", elem->key);
-			pthread_exit((void *)FAIL_CODE);
+			printf(",%lld,%lld,%lld", hist_percentile(&hist[j], 0.50),
+				   hist_percentile(&hist[j], 0.99), hist_percentile(&hist[j], 0.999));
 		}
 	}
 
-	free(keys);
+	// With --perf: cycles, instructions, LLC misses, transfers per operation
+	if (perf)
+		perf_print(perf, num_operations);
 
-	pthread_exit(NULL);
+	if (ci)
+	{
+		printf(",%.0f,%.2f", ci[0], ci[1]);
+	}
+	printf("\n");
 }
 
-int main(int argc, char** argv)
+// INPUT: Iterations per thread, histograms to merge latencies into
+// Run the test once with the current thread, list and sync settings
+void run_test(int num_iterations, struct latency_hist* total_hist,
+			  struct run_result* result)
 {
-	// printf("%s\n", "START");
-	// Default threads/iterations to 1
-	char def_value[2] = {'1'};
-	char* str_threads = def_value;
-	char* str_iterations = def_value;
-	char* str_yield = NULL;
-	opt_yield = 0;
-	process_cl_arugments(argc, argv, &str_threads, &str_iterations, &str_yield);
+	select_list_lock();
 
-	int num_threads = atoi(str_threads);
-	int num_iterations = atoi(str_iterations);
+	// --sync=lf, h and z take no sublist lock and run on a list
+	// that synchronizes itself instead
+	const char* forced = list_forced_by_sync();
+	SortedList_set_impl(forced ? forced : list_impl);
+
+	// Local placement only makes sense for pinned threads
+	if (numa_policy && *numa_policy == 'l' && affinity == NULL)
+		affinity = "compact";
+	if (affinity)
+		thread_cpu = plan_affinity(affinity, num_threads);
 
 	// Split up list
 	// printf("%s\n", "HEAD");
 	head = (SortedList_t **) malloc(sizeof(SortedList_t*) * num_lists);
-	if (head == NULL)
+	lists = (struct sublist **) malloc(sizeof(struct sublist*) * num_lists);
+	if (head == NULL || lists == NULL)
 	{
 		process_failed_sys_call("malloc");
 	}
 
+	// One CLH node per thread plus an unlocked initial tail per list
+	clh_nodes = (struct clh_node *) alloc_cache_aligned((num_threads + num_lists) * sizeof(struct clh_node));
+
+	if (sync_method && *sync_method == 'r' && opt_big_reader)
+	{
+		br_locks = (struct br_lock *) alloc_cache_aligned(sizeof(struct br_lock) * num_lists);
+	}
+
+	size_t sublist_size = sizeof(struct sublist) + SortedList_element_size;
 	int j;
 	for (j = 0; j < num_lists; j++)
 	{
-		head[j] = (SortedList_t *) malloc(sizeof(SortedList_t));
-		head[j]->key = NULL;
-		head[j]->next = NULL;
-		head[j]->prev = NULL;
+		// Keys hash across every sublist, spread them over the threads' nodes
+		if (numa_policy && *numa_policy == 'l')
+			lists[j] = (struct sublist *) alloc_on_node(sublist_size,
+														cpu_node(thread_cpu[j % num_threads]));
+		else
+			lists[j] = (struct sublist *) calloc(1, sublist_size);
+		if (lists[j] == NULL)
+		{
+			process_failed_sys_call("malloc");
+		}
+
+		// Both allocations are zero filled, leaving an empty list
+		head[j] = (SortedList_t *) (lists[j] + 1);
+
+		pthread_mutex_init(&lists[j]->mutex, NULL);
+		pthread_rwlock_init(&lists[j]->rwlock, NULL);
+		lists[j]->clh.tail = &clh_nodes[num_threads + j];
+		if (br_locks)
+			lists[j]->br = &br_locks[j];
+	}
+
+	// Initialize a 2D array of list nodes, timed apart from the test
+	struct timespec setup_start;
+	if (clock_gettime(CLOCK_MONOTONIC, &setup_start) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
 	}
 
-	// Initialize a 2D array of list nodes
 	long long count = num_iterations * num_threads;
 	SortedListElement_t** list_elements = generate_list_nodes(count);
 
-	// Register handler
-	if (signal(SIGSEGV, signal_handler) == SIG_ERR)
+	struct timespec setup_end;
+	if (clock_gettime(CLOCK_MONOTONIC, &setup_end) == -1)
 	{
-		process_failed_sys_call("signal");
+		process_failed_sys_call("clock_gettime");
 	}
+	result->setup_time = get_time_dif(setup_start, setup_end);
 
-	if (sync_method)
+	// Occupancy skew: elements in the fullest sublist over the mean
+	long long* occupancy = (long long *) calloc(num_lists, sizeof(long long));
+	if (occupancy == NULL)
 	{
-		mutex = (pthread_mutex_t *) malloc(sizeof(pthread_mutex_t) * num_lists);
-		int i;
-		for (i = 0; i < num_lists; i++)
-		{
-			pthread_mutex_init(&mutex[i], NULL);
-		}
+		process_failed_sys_call("malloc");
+	}
 
-		lock = (int *) malloc(sizeof(int) * num_lists);
-		for (i = 0; i < num_lists; i++)
-		{
-			lock[i] = 0;
-		}
+	long long most = 0;
+	long long e;
+	for (e = 0; e < count; e++)
+	{
+		int list = key_list(list_elements[e]->key);
+		if (++occupancy[list] > most)
+			most = occupancy[list];
 	}
+	free(occupancy);
+	result->skew = (double) most * num_lists / count;
 
-	struct timespec starting;
-	if (clock_gettime(CLOCK_REALTIME, &starting) == -1)
+	// Without a sublist lock (lf, h, z, or any --impl run unlocked)
+	// threads update the counts concurrently, so each gets a row of
+	// counts, padded to whole cache lines. The flat combiner holds a lock
+	if (lock_list == lock_none && !(sync_method && *sync_method == 'o'))
 	{
-		process_failed_sys_call("clock_gettime");
+		size_stride = (num_lists + 7) & ~7;
+		size_counts = (long long *) alloc_cache_aligned(sizeof(long long) * size_stride * num_threads);
+	}
+
+	// One publication slot per thread in every sublist
+	if (sync_method && *sync_method == 'o')
+	{
+		fc_slots = (struct fc_slot *) alloc_cache_aligned(num_lists * num_threads * sizeof(struct fc_slot));
+	}
+
+	// Only --duration reuses elements, and only unlocked lists need to wait
+	if (duration > 0 && lock_list == lock_none && !(sync_method && *sync_method == 'o'))
+	{
+		phase_slots = (struct phase_slot *) alloc_cache_aligned(num_threads * sizeof(struct phase_slot));
+	}
+
+	// Main joins the start barrier so it can time from the moment all
+	// threads are ready until the last one is joined
+	if (pthread_barrier_init(&start_barrier, NULL, num_threads + 1) != 0)
+	{
+		process_failed_sys_call("pthread_barrier_init");
 	}
 
 	pthread_t* threads = (pthread_t*) malloc(sizeof(pthread_t) * num_threads);
@@ -384,6 +2087,9 @@ int main(int argc, char** argv)
 	}
 
 	long long lock_waiting_time = 0;
+	long long total_rounds = 0;
+	long long extra_lookups = 0;
+	stop_flag = 0;
 
 	struct thread_args** t_args = (struct thread_args **) malloc(sizeof(struct thread_args *) * num_threads);
 	long long i;
@@ -399,11 +2105,38 @@ int main(int argc, char** argv)
 		t_args[i]->num_elements = count;
 		t_args[i]->thread_id = i;
 		t_args[i]->my_wait = 0;
-
-		if (pthread_create(&threads[i], NULL, update_list, (void *)t_args[i]) != 0)
+		t_args[i]->rounds = 0;
+		t_args[i]->extra_lookups = 0;
+		t_args[i]->hist = NULL;
+		if (opt_latency)
 		{
-			process_failed_sys_call("pthread_create");
+			t_args[i]->hist = (struct latency_hist *) calloc(NUM_OPS, sizeof(struct latency_hist));
+			if (t_args[i]->hist == NULL)
+			{
+				process_failed_sys_call("malloc");
+			}
 		}
+
+		create_pinned_thread(&threads[i], i, update_list, (void *)t_args[i]);
+	}
+
+	pthread_barrier_wait(&start_barrier);
+
+	struct timespec starting;
+	if (clock_gettime(CLOCK_MONOTONIC, &starting) == -1)
+	{
+		process_failed_sys_call("clock_gettime");
+	}
+
+	pthread_barrier_wait(&start_barrier);
+
+	if (duration > 0)
+	{
+		struct timespec run_for;
+		run_for.tv_sec = (time_t) duration;
+		run_for.tv_nsec = (long) ((duration - run_for.tv_sec) * 1000000000);
+		while (nanosleep(&run_for, &run_for) == -1 && errno == EINTR);
+		__atomic_store_n(&stop_flag, 1, __ATOMIC_RELAXED);
 	}
 
 	void* status;
@@ -421,22 +2154,40 @@ int main(int argc, char** argv)
 
 	free(threads);
 
+	memset(&result->perf, 0, sizeof(result->perf));
 	for (i = 0; i < num_threads; i++)
 	{
 		lock_waiting_time += t_args[i]->my_wait;
+		total_rounds += t_args[i]->rounds;
+		extra_lookups += t_args[i]->extra_lookups;
+		if (opt_perf)
+			perf_merge(&result->perf, &t_args[i]->perf);
 	}
 
+	// Merge every thread's histograms into the caller's
 	for (i = num_threads - 1; i >= 0; i--)
 	{
+		if (total_hist)
+		{
+			for (j = 0; j < NUM_OPS; j++)
+			{
+				hist_merge(&total_hist[j], &t_args[i]->hist[j]);
+			}
+		}
+		free(t_args[i]->hist);
 		free(t_args[i]);
 	}
 	free(t_args);
+	pthread_barrier_destroy(&start_barrier);
 
 	// printf("%s\n", "ALL LENGTH");
+	// The walk checks the lists themselves, then the counts must agree
 	int len = 0;
 	for (i = 0; i < num_lists; i++)
 	{
 		len += SortedList_length(head[i]);
+		if (list_size(i) != 0)
+			len = -1;
 	}
 
 	if (len != 0)
@@ -446,53 +2197,209 @@ int main(int argc, char** argv)
 	}
 
 	struct timespec ending;
-	if (clock_gettime(CLOCK_REALTIME, &ending) == -1)
+	if (clock_gettime(CLOCK_MONOTONIC, &ending) == -1)
 	{
 		process_failed_sys_call("clock_gettime");
 	}
 
-	printf("%s", "list-");
-	if (str_yield == NULL)
-		printf("%s", "none-");
-	else
-		printf("%s-", str_yield);
-	if (sync_method == NULL)
-		printf("%s", "none,");
-	else
-		printf("%s,", sync_method);
-	printf("%d%s", num_threads, ",");
-	printf("%d%s", num_iterations, ",");
-	printf("%d%s", num_lists, ",");
+	// Every round is one insert, lookup and delete per iteration,
+	// plus any extra lookups from --reads
+	result->operations = total_rounds * num_iterations * 3 + extra_lookups;
+	result->run_time = get_time_dif(starting, ending);
+	result->lock_wait = lock_waiting_time;
 
-	long long num_operations = num_iterations * num_threads * 3;
+	if (numa_blocks)
+	{
+		for (i = 0; i < num_threads; i++)
+		{
+			munmap(numa_blocks[i], numa_block_size);
+		}
+		free(numa_blocks);
+		numa_blocks = NULL;
+	}
+	free(element_arena);
+	element_arena = NULL;
+	free(list_elements);
+	for (i = num_lists - 1; i >= 0; --i)
+	{
+		if (numa_policy && *numa_policy == 'l')
+			munmap(lists[i], sublist_size);
+		else
+			free(lists[i]);
+	}
+	free(lists);
+	free(head);
+	free(clh_nodes);
+	free(br_locks);
+	br_locks = NULL;
+	free(thread_cpu);
+	free(fc_slots);
+	free(size_counts);
+	free(phase_slots);
+	thread_cpu = NULL;
+	fc_slots = NULL;
+	size_counts = NULL;
+	phase_slots = NULL;
+}
 
-	printf("%lld%s", num_operations, ",");
+// INPUT: Comma separated thread counts, iteration counts, list counts and
+//        sync methods, plus the yield setting for the test name
+// Run every combination after a warmup and print one record per combination
+// with the mean of the repetitions and 95% confidence intervals
+void run_sweep(char* str_threads, char* str_iterations, char* str_lists,
+			   char* str_sync, char* str_yield)
+{
+	int thread_values[MAX_SWEEP];
+	int iteration_values[MAX_SWEEP];
+	int list_values[MAX_SWEEP];
+	int num_thread_values = parse_int_list(str_threads, thread_values);
+	int num_iteration_values = parse_int_list(str_iterations, iteration_values);
+	int num_list_values = parse_int_list(str_lists, list_values);
+
+	// Split the sync methods, "none" runs without synchronization
+	char* sync_values[MAX_SWEEP];
+	int num_sync_values = 0;
+	char* sync_copy = strdup(str_sync ? str_sync : "none");
+	char* token = strtok(sync_copy, ",");
+	while (token && num_sync_values < MAX_SWEEP)
+	{
+		sync_values[num_sync_values++] = strcmp(token, "none") == 0 ? NULL : token;
+		token = strtok(NULL, ",");
+	}
+
+	if (sweep_reps < 1)
+		sweep_reps = 1;
+
+	double* run_times = (double *) malloc(sizeof(double) * sweep_reps);
+	double* op_times = (double *) malloc(sizeof(double) * sweep_reps);
+	struct latency_hist* hist = NULL;
+	if (opt_latency)
+		hist = (struct latency_hist *) malloc(sizeof(struct latency_hist) * NUM_OPS);
+	if (run_times == NULL || op_times == NULL || (opt_latency && hist == NULL))
+	{
+		process_failed_sys_call("malloc");
+	}
 
-	long run_time = ending.tv_nsec - starting.tv_nsec;
-	if (run_time < 0)
+	int s, t, it, l, rep;
+	for (s = 0; s < num_sync_values; s++)
 	{
-		run_time += 1000000000;
+		sync_method = sync_values[s];
+		for (t = 0; t < num_thread_values; t++)
+		{
+			num_threads = thread_values[t];
+			for (it = 0; it < num_iteration_values; it++)
+			{
+				for (l = 0; l < num_list_values; l++)
+				{
+					num_lists = list_values[l];
+
+					struct run_result result;
+					for (rep = 0; rep < sweep_warmup; rep++)
+					{
+						run_test(iteration_values[it], NULL, &result);
+					}
+
+					if (hist)
+						memset(hist, 0, sizeof(struct latency_hist) * NUM_OPS);
+
+					long long operations = 0;
+					long long lock_wait = 0;
+					double skew = 0;
+					long long setup_time = 0;
+					struct perf_counts perf;
+					memset(&perf, 0, sizeof(perf));
+					for (rep = 0; rep < sweep_reps; rep++)
+					{
+						run_test(iteration_values[it], hist, &result);
+						run_times[rep] = result.run_time;
+						op_times[rep] = (double) result.run_time / result.operations;
+						operations += result.operations;
+						lock_wait += result.lock_wait;
+						skew += result.skew;
+						setup_time += result.setup_time;
+						perf_merge(&perf, &result.perf);
+					}
+
+					// Per operation counts cover every repetition
+					int i;
+					for (i = 0; i < NUM_PERF; i++)
+					{
+						if (perf.value[i] != -1)
+							perf.value[i] /= sweep_reps;
+					}
+
+					double run_time;
+					double op_time;
+					double ci[2];
+					ci[0] = confidence_interval(run_times, sweep_reps, &run_time);
+					ci[1] = confidence_interval(op_times, sweep_reps, &op_time);
+
+					char name[64];
+					build_test_name(name, sizeof(name), str_yield);
+					print_results(name, iteration_values[it], operations / sweep_reps,
+								  (long long) run_time, lock_wait / sweep_reps,
+								  skew / sweep_reps, setup_time / sweep_reps, hist,
+								  opt_perf ? &perf : NULL, ci);
+					fflush(stdout);
+				}
+			}
+		}
 	}
 
-	printf("%ld%s", run_time, ",");
+	free(run_times);
+	free(op_times);
+	free(hist);
+	free(sync_copy);
+}
 
-	long avg_time_per_operation = run_time / num_operations;
+int main(int argc, char** argv)
+{
+	// printf("%s\n", "START");
+	// Default threads/iterations to 1
+	char def_value[2] = {'1'};
+	char* str_threads = def_value;
+	char* str_iterations = def_value;
+	char* str_lists = def_value;
+	char* str_yield = NULL;
+	opt_yield = 0;
+	process_cl_arugments(argc, argv, &str_threads, &str_iterations, &str_yield, &str_lists);
 
-	printf("%ld,", avg_time_per_operation);
+	if (numa_policy && *numa_policy == 'i')
+		interleave_memory();
 
-	printf("%lld\n", lock_waiting_time / num_operations);
+	// Register handler
+	if (signal(SIGSEGV, signal_handler) == SIG_ERR)
+	{
+		process_failed_sys_call("signal");
+	}
 
-	for (i = count - 1; i >= 0; --i)
+	if (opt_sweep)
 	{
-		free((char *)list_elements[i]->key);
-		free(list_elements[i]);
+		run_sweep(str_threads, str_iterations, str_lists, sync_method, str_yield);
+		exit(SUCCESS_CODE);
 	}
-	free(list_elements);
-	for (i = num_lists - 1; i >= 0; --i)
+
+	num_threads = atoi(str_threads);
+	int num_iterations = atoi(str_iterations);
+
+	struct latency_hist* hist = NULL;
+	if (opt_latency)
 	{
-		free(head[i]);
+		hist = (struct latency_hist *) calloc(NUM_OPS, sizeof(struct latency_hist));
+		if (hist == NULL)
+		{
+			process_failed_sys_call("malloc");
+		}
 	}
-	free(head);
-	free(mutex);
+
+	struct run_result result;
+	run_test(num_iterations, hist, &result);
+
+	char name[64];
+	build_test_name(name, sizeof(name), str_yield);
+	print_results(name, num_iterations, result.operations, result.run_time,
+				  result.lock_wait, result.skew, result.setup_time, hist, opt_perf ? &result.perf : NULL, NULL);
+
+	free(hist);
 	exit(SUCCESS_CODE);
 }